@@ -0,0 +1,43 @@
+#pragma once
+#include "RandomEngine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief An AliasTable picks positions at random in proportion to a weight per position, in the same time however many positions there are.
+ *
+ * Built with Vose's alias method. Every position is a column that keeps itself some of the time and hands off to one alias the rest,
+ * so a pick is one uniform column and one coin flip.
+ */
+class AliasTable
+{
+public:
+    AliasTable() = default;
+
+    /**
+     * \brief Builds the table for the given weights. If no weight is above 0 every position is equally likely.
+     * \param weights Weight of each position. Negative weights count as 0.
+     */
+    explicit AliasTable(const std::vector<double>& weights);
+    ~AliasTable() = default;
+
+    /**
+     * \brief Get the number of positions in the table.
+     * \return Number of positions.
+     */
+    size_t size() const;
+
+    /**
+     * \brief Picks a random position.
+     * \param engine Random engine to pick with.
+     * \return Position that was picked. Must not be called on an empty table.
+     */
+    size_t sample(RandomEngine& engine) const;
+
+private:
+    // Chance out of 2^32 that a column keeps itself rather than going to its alias.
+    std::vector<uint32_t> mThresholds;
+    std::vector<uint32_t> mAliases;
+};
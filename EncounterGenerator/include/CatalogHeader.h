@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * \brief A CatalogHeader starts every binary catalog file.
+ *
+ * After it come the sections of the catalog back to back. A section is its number of values, the size of one value,
+ * then the values themselves, padded out to CATALOG_ALIGNMENT so every section can be used in place.
+ */
+struct CatalogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t size;
+};
+
+static const char CATALOG_MAGIC[8] = { 'P', 'F', 'C', 'A', 'T', 'A', 'L', 'G' };
+
+// Goes up whenever the sections of any catalog change, or what they hold, so old catalogs get turned away instead of misread.
+// Version 1 catalogs have every creature size read as Tiny. Version 2 catalogs have no fallback levels in their index.
+static const uint32_t CATALOG_VERSION = 3;
+
+// Reads back as something else on a machine with the other byte order.
+static const uint32_t CATALOG_BYTE_ORDER = 0x01020304;
+
+static const uint64_t CATALOG_ALIGNMENT = 8;
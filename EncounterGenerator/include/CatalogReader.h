@@ -0,0 +1,86 @@
+#pragma once
+#include "Column.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+/**
+ * \brief A CatalogReader maps a binary catalog written by a CatalogWriter and hands its sections back out in order.
+ *
+ * Nothing is parsed or copied. Columns read from the catalog look straight at the mapped file and keep it mapped for as long as they are around.
+ * Only the shape of the catalog is checked, so it should come from a CatalogWriter and nowhere else.
+ */
+class CatalogReader
+{
+public:
+    /**
+     * \brief Maps the given catalog and checks its header. Check isValid to see if it worked.
+     * \param filePath Path of the catalog.
+     */
+    explicit CatalogReader(const std::string& filePath);
+    ~CatalogReader() = default;
+
+    /**
+     * \brief If everything read so far was read correctly. Goes false at the first read that doesn't fit the catalog and stays false.
+     * \return If the catalog is valid so far.
+     */
+    bool isValid() const;
+
+    /**
+     * \brief If every section of the catalog has been read.
+     * \return If the end of the catalog was reached.
+     */
+    bool isAtEnd() const;
+
+    /**
+     * \brief Read a section holding a single number.
+     * \param value Set to the number.
+     * \return If the number was read.
+     */
+    bool readValue(uint64_t& value);
+
+    /**
+     * \brief Read a section holding a column of values.
+     * \param column Set to a column that looks at the values in the catalog.
+     * \return If the column was read.
+     */
+    template<typename T>
+    bool readColumn(Column<T>& column)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be used in place from a catalog.");
+
+        uint64_t count = 0;
+        const auto* values = readSection(count, sizeof(T));
+        if (values == nullptr)
+        {
+            return false;
+        }
+
+        column = Column<T>(std::shared_ptr<const T>(mFile, reinterpret_cast<const T*>(values)), static_cast<size_t>(count));
+        return true;
+    }
+
+private:
+    /**
+     * \brief Read the next section of the catalog.
+     * \param count Set to the number of values in the section.
+     * \param valueSize Size one value is expected to have.
+     * \return First of the values in the section, or null if the section doesn't fit.
+     */
+    const char* readSection(uint64_t& count, uint64_t valueSize);
+
+    /**
+     * \brief Move past the given number of bytes and the padding after them.
+     * \param length Number of bytes.
+     * \return Start of the bytes, or null if they go past the end of the catalog.
+     */
+    const char* skip(uint64_t length);
+
+    std::shared_ptr<const MappedFile> mFile;
+    uint64_t mPosition{};
+    uint64_t mSize{};
+    bool mIsValid{};
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include "Column.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * \brief A CatalogWriter lays out the sections of a binary catalog in memory and then writes them to a file in one go.
+ *
+ * Sections have no names, so they have to be read back in the same order they were written.
+ */
+class CatalogWriter
+{
+public:
+    CatalogWriter();
+    ~CatalogWriter() = default;
+
+    /**
+     * \brief Add a section holding a single number.
+     * \param value Number to write.
+     */
+    void writeValue(uint64_t value);
+
+    /**
+     * \brief Add a section holding every value of a column.
+     * \param column Values to write.
+     */
+    template<typename T>
+    void writeColumn(const Column<T>& column)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be used in place from a catalog.");
+        writeSection(column.data(), column.size(), sizeof(T));
+    }
+
+    /**
+     * \brief Write the catalog to the given file, replacing what was there.
+     * \param filePath Path of the file to write.
+     * \return If the whole catalog was written.
+     */
+    bool writeToFile(const std::string& filePath);
+
+private:
+    /**
+     * \brief Add a section to the end of the catalog.
+     * \param values First of the values.
+     * \param count Number of values.
+     * \param valueSize Size of one value in bytes.
+     */
+    void writeSection(const void* values, size_t count, size_t valueSize);
+
+    /**
+     * \brief Add bytes to the end of the catalog, followed by zeros up to the next alignment.
+     * \param bytes Bytes to add.
+     * \param length Number of bytes.
+     */
+    void append(const void* bytes, size_t length);
+
+    std::string mBytes;
+};
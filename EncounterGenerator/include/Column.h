@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief A Column is an array of values that either owns its values or looks at values kept alive by something else, like a mapped file.
+ *
+ * Reading works the same either way. Changing a column that doesn't own its values copies them into the column first.
+ */
+template<typename T>
+class Column
+{
+public:
+    Column() = default;
+    Column(std::initializer_list<T> values) : mOwned(values) {}
+    explicit Column(std::vector<T> values) : mOwned(std::move(values)) {}
+
+    /**
+     * \brief Creates a column that looks at values it doesn't own.
+     * \param values First of the values. Keeps whatever owns them alive for as long as the column, or a copy of it, looks at them.
+     * \param size Number of values.
+     */
+    Column(std::shared_ptr<const T> values, size_t size) : mShared(std::move(values)), mSharedSize{ size } {}
+
+    const T* data() const { return mShared ? mShared.get() : mOwned.data(); }
+    size_t size() const { return mShared ? mSharedSize : mOwned.size(); }
+    bool empty() const { return size() == 0; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    const T& operator[](size_t index) const { return data()[index]; }
+
+    /**
+     * \brief Gets the values for changing them, copying them into the column first if it doesn't own them.
+     * \return Values of the column.
+     */
+    std::vector<T>& getMutable()
+    {
+        if (mShared)
+        {
+            mOwned.assign(mShared.get(), mShared.get() + mSharedSize);
+            mShared.reset();
+            mSharedSize = 0;
+        }
+        return mOwned;
+    }
+
+private:
+    std::vector<T> mOwned;
+    std::shared_ptr<const T> mShared;
+    size_t mSharedSize{};
+};
@@ -1,19 +1,43 @@
 #pragma once
 #include "GeneratorUtilities.h"
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <string>
 
 using namespace Pathfinder;
 
 /**
  * \brief An Encounter is a mapping of level and the number of monsters of that level.
+ *
+ * The mapping is stored inline, sorted by level, along with its xp and monster counts, so an encounter never allocates and can be copied with memcpy.
  */
 class Encounter
 {
 public:
+    /**
+     * \brief Most monster levels an encounter holds. Only this many levels around the adventurer level reward any xp.
+     */
+    static constexpr uint32_t MAX_MONSTER_LEVELS = 15;
+
+    /**
+     * \brief A number of monsters that all have the same level.
+     */
+    struct MonsterGroup
+    {
+        int16_t level;
+        uint16_t count;
+    };
+
     Encounter(const int32_t& adventurerLevel);
     ~Encounter() = default;
 
+    bool operator==(const Encounter& other) const;
+    bool operator!=(const Encounter& other) const;
+    bool operator<(const Encounter& other) const;
+
     /**
      * \brief Returns the level of adventurers involved in this encounter.
      * \return Level of adventurers involved in this encounter.
@@ -22,10 +46,14 @@ public:
 
     /**
      * \brief Add monsters to this encounter.
+     *
+     * Monsters of a new level are not added once the encounter already holds MAX_MONSTER_LEVELS levels,
+     * and a level never holds more than 65535 monsters.
      * \param level The level of the monsters you want to add.
      * \param numMonsters The number of monsters you want to add.
+     * \return If every monster was added. False if the level didn't fit or only some of the monsters did.
      */
-    void addMonsters(int32_t level, uint32_t numMonsters);
+    bool addMonsters(int32_t level, uint32_t numMonsters);
 
     /**
      * \brief Remove monsters from this encounter.
@@ -36,10 +64,24 @@ public:
 
     /**
      * \brief Get the monster levels that are in this encounter and how many of them there are.
+     *
+     * Builds a new map on every call, prefer iterating over the encounter.
      * \return Monster level map of this encounter.
      */
     std::map<int32_t, uint32_t> getMonsterLevelToCountMap() const;
 
+    /**
+     * \brief Iterate over the monster groups of this encounter in increasing level order.
+     * \return First monster group of this encounter.
+     */
+    const MonsterGroup* begin() const;
+
+    /**
+     * \brief Iterate over the monster groups of this encounter in increasing level order.
+     * \return One past the last monster group of this encounter.
+     */
+    const MonsterGroup* end() const;
+
     /**
      * \brief Get the number of unique monsters in this encounter.
      * \return Number of unique monsters in this encounter.
@@ -58,6 +100,12 @@ public:
      */
     uint32_t getEncounterXp() const;
 
+    /**
+     * \brief Hashes the adventurer level and monster groups of this encounter.
+     * \return Hash of this encounter.
+     */
+    size_t hash() const;
+
     /**
      * \brief Converts the current encounter into a string.
      *
@@ -66,8 +114,29 @@ public:
      */
     std::string toString() const;
 
+    /**
+     * \brief Adds the string form of the current encounter to the end of a buffer, in the same form as toString.
+     * \param buffer Buffer to add to. Reusing one buffer for many encounters saves making a string for each.
+     */
+    void appendString(std::string& buffer) const;
+
 private:
     int32_t mAdventurerLevel;
-    std::map<int32_t, uint32_t> mMonsterLevelToCountMap;
+    uint32_t mEncounterXp;
+    uint32_t mNumTotalMonsters;
+    uint32_t mNumUniqueMonsters;
+    std::array<MonsterGroup, MAX_MONSTER_LEVELS> mMonsterGroups;
 
 };
+
+namespace std
+{
+    template <>
+    struct hash<Encounter>
+    {
+        size_t operator()(const Encounter& encounter) const
+        {
+            return encounter.hash();
+        }
+    };
+}
@@ -1,14 +1,24 @@
 #pragma once
-#include <vector>
+#include <array>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "Encounter.h"
+#include "EncounterSampler.h"
+#include "EncounterTemplate.h"
 #include "Party.h"
+#include "RandomEngine.h"
+#include "WorkStealingPool.h"
 
 using namespace Pathfinder;
 
 /**
  * \brief The EncounterGenerator takes a party of adventurers and generates lists of valid encounters of all the difficulty types.
+ *
+ * Encounters of a difficulty are generated the first time they are asked for. Asking from several threads at once is safe.
  */
 class EncounterGenerator
 {
@@ -18,8 +28,10 @@ public:
      * \param adventurers A party of adventurers.
      * \param numUniqueMonsters How many unique monsters to field.
      * \param numTotalMonsters Maximum number of monsters to field.
+     * \param numThreads Number of threads to search for encounters with. 1 searches on the calling thread, 0 uses one per hardware thread.
+     *                   The encounters found are the same for any number of threads.
      */
-    EncounterGenerator(const Party& adventurers, const uint32_t& numUniqueMonsters, const uint32_t& numTotalMonsters);
+    EncounterGenerator(const Party& adventurers, const uint32_t& numUniqueMonsters, const uint32_t& numTotalMonsters, const uint32_t& numThreads = 1);
     ~EncounterGenerator() = default;
 
     /**
@@ -30,32 +42,190 @@ public:
      */
     std::vector<Encounter> getEncounters(const Difficulty& difficulty, uint32_t numBattles) const;
 
+    /**
+     * \brief Get a number of encounters from the valid encounters. If asking for more than available, loops over the available.
+     * \param difficulty Difficulty of the encounters to grab.
+     * \param numBattles Number of encounters to grab.
+     * \param engine Random engine to pick with. The same engine state always picks the same encounters.
+     * \return Number of encounters of the given difficulty.
+     */
+    std::vector<Encounter> getEncounters(const Difficulty& difficulty, uint32_t numBattles, RandomEngine& engine) const;
+
     /**
      * \brief Get all of the valid encounters of the given difficulty.
      * \param difficulty Difficulty of encounters to be grabbed.
+     * \return Encounters of the given difficulty. Stays valid for as long as the generator does.
+     */
+    const std::vector<Encounter>& getAllEncounters(const Difficulty& difficulty) const;
+
+    /**
+     * \brief Pick a number of encounters from the valid encounters without copying any. If asking for more than available, loops over the available.
+     * \param difficulty Difficulty of the encounters to pick.
+     * \param numBattles Number of encounters to pick.
+     * \param engine Random engine to pick with. The same engine state always picks the same encounters.
+     * \return Indices into getAllEncounters(difficulty) of the picked encounters.
+     */
+    std::vector<size_t> sampleEncounterIndices(const Difficulty& difficulty, uint32_t numBattles, RandomEngine& engine) const;
+
+    /**
+     * \brief Count every valid composition of monster levels of the given difficulty.
+     *
+     * Unlike getAllEncounters, this is not limited to one encounter per total number of monsters.
+     * \param difficulty Difficulty of the encounters to count.
+     * \return Number of valid compositions of the given difficulty.
+     */
+    uint64_t countEncounters(const Difficulty& difficulty) const;
+
+    /**
+     * \brief Draw encounters uniformly at random from every valid composition of the given difficulty, without enumerating them.
+     * \param difficulty Difficulty of the encounters to draw.
+     * \param numBattles Number of encounters to draw. Encounters may repeat.
+     * \return Encounters of the given difficulty.
+     */
+    std::vector<Encounter> sampleEncounters(const Difficulty& difficulty, uint32_t numBattles) const;
+
+    /**
+     * \brief Draw encounters uniformly at random from every valid composition of the given difficulty, without enumerating them.
+     * \param difficulty Difficulty of the encounters to draw.
+     * \param numBattles Number of encounters to draw. Encounters may repeat.
+     * \param engine Random engine to draw with. The same engine state always draws the same encounters.
      * \return Encounters of the given difficulty.
      */
-    std::vector<Encounter> getAllEncounters(const Difficulty& difficulty) const;
+    std::vector<Encounter> sampleEncounters(const Difficulty& difficulty, uint32_t numBattles, RandomEngine& engine) const;
 
 private:
     static const std::vector<float> MONSTER_ENCOUNTER_MODIFIERS;
 
-    Encounter convertMonsterVectorToEncounter(const std::vector<uint32_t>& monsterXpVector) const;
+    /**
+     * \brief A monster xp that the search may add to an encounter, pre-resolved for the party.
+     */
+    struct SearchEntry
+    {
+        // Level of the monsters added by this entry, relative to the party level.
+        int32_t levelOffset;
+        // Xp that each monster added by this entry rewards.
+        uint32_t monsterXp;
+        // How many monsters are added at once when this entry is picked.
+        uint32_t chunkSize;
+
+        bool operator<(const SearchEntry& other) const;
+    };
+
+    /**
+     * \brief Everything a search depends on. Parties that share a key share the same templates, whatever their level.
+     */
+    struct SearchKey
+    {
+        std::vector<SearchEntry> entries;
+        uint32_t lowXp;
+        uint32_t highXp;
+        uint32_t numUniqueMonsters;
+        uint32_t numTotalMonsters;
+
+        bool operator<(const SearchKey& other) const;
+    };
+
+    /**
+     * \brief Running state of the encounter the search is currently building.
+     */
+    struct SearchState
+    {
+        // Level offset and count of each monster group, in the order they were added.
+        std::vector<std::pair<int32_t, uint32_t>> monsterGroups;
+        uint32_t xp;
+        uint32_t numTotalMonsters;
+        // Total monster counts that already have an encounter for this difficulty.
+        std::vector<bool> usedTotalMonsters;
+    };
+
+    /**
+     * \brief In-range encounters found by one subtree of a parallel search, in the order the sequential search visits them.
+     */
+    struct SearchRecords
+    {
+        struct Record
+        {
+            uint32_t numTotalMonsters;
+            // Number of records that follow this one and belong to its subtree.
+            size_t numDescendants;
+            size_t firstGroup;
+            size_t numGroups;
+        };
+
+        std::vector<Record> records;
+        std::vector<std::pair<int32_t, uint32_t>> monsterGroups;
+    };
+
+    /**
+     * \brief How many levels of the search tree are walked before the rest is handed out as tasks.
+     */
+    static const uint32_t PARALLEL_SPLIT_DEPTH;
 
     static std::vector<uint32_t> getValidMonsterXPs(const uint32_t& minXp, const uint32_t& maxXp);
 
+    SearchKey getSearchKey(const Difficulty& difficulty) const;
+
     void setMinimumMonsterXp();
     uint32_t getMinimumMonsterXp(const Difficulty& difficulty) const;
     void setMaximumMonsterXp();
     uint32_t getMaximumMonsterXp(const Difficulty& difficulty) const;
 
-    void fillOutEncounters();
-    void fillOutHelper(std::vector<uint32_t>& currentMonsters, const Difficulty& difficulty, const std::vector<uint32_t>& validXps, const uint32_t& lowXp, const uint32_t& desiredXp, const uint32_t& highXp);
+    /**
+     * \brief Encounters of one difficulty and whether they have been generated yet.
+     */
+    struct DifficultyBattles
+    {
+        std::once_flag generated;
+        std::vector<Encounter> battles;
+    };
+
+    /**
+     * \brief Gets the encounters of the given difficulty, generating them if this is the first time they are asked for.
+     * \param difficulty Difficulty of the encounters.
+     * \return Encounters of the given difficulty.
+     */
+    const std::vector<Encounter>& getValidBattles(const Difficulty& difficulty) const;
+
+    std::vector<Encounter> fillOutEncounters(const Difficulty& difficulty) const;
+
+    /**
+     * \brief Gets the templates for the given search, running the search only if no party has needed it before.
+     * \param key Search to get the templates of.
+     * \param numThreads Number of threads to run the search on if it has to be run. 0 uses one per hardware thread.
+     * \return Templates found by the search.
+     */
+    static std::shared_ptr<const std::vector<EncounterTemplate>> getTemplates(const SearchKey& key, const uint32_t& numThreads);
+    /**
+     * \brief Gets the composition counts for the given search, building them only if no party has needed them before.
+     * \param key Search to get the composition counts of.
+     * \return Sampler over every composition the search allows.
+     */
+    static std::shared_ptr<const EncounterSampler> getSampler(const SearchKey& key);
+
+    static void fillOutHelper(SearchState& state, const SearchKey& key, const size_t& firstEntry, std::vector<EncounterTemplate>& templates);
+
+    /**
+     * \brief Searches the tree on the given pool and replays the acceptance rules over what was found, in sequential order.
+     * \param key Search to run.
+     * \param pool Pool to search on.
+     * \return The same templates the sequential search finds.
+     */
+    static std::vector<EncounterTemplate> searchInParallel(const SearchKey& key, WorkStealingPool& pool);
+    static void splitHelper(SearchState& state, const SearchKey& key, const size_t& firstEntry, const uint32_t& depth, WorkStealingPool& pool, std::deque<SearchRecords>& segments, std::vector<std::pair<size_t, size_t>>& prefixSubtrees);
+    static void recordHelper(SearchState& state, const SearchKey& key, const size_t& firstEntry, SearchRecords& records);
+    static void addRecord(const SearchState& state, SearchRecords& records);
+
+    /**
+     * \brief Calls visit for every entry that can be added to the current encounter without going over a limit, with the entry added to the state.
+     */
+    template <typename Visit>
+    static void forEachChild(SearchState& state, const SearchKey& key, const size_t& firstEntry, const Visit& visit);
 
     Party mParty;
     uint32_t mNumUniqueMonsters{};
     uint32_t mNumTotalMonsters{};
+    uint32_t mNumThreads{};
     std::map<Difficulty, uint32_t> mMinimumMonsterXp{};
     std::map<Difficulty, uint32_t> mMaximumMonsterXp{};
-    std::map<Difficulty, std::vector<Encounter>> mValidBattles{};
+    mutable std::array<DifficultyBattles, static_cast<size_t>(Difficulty::INVALID)> mValidBattles{};
 };
@@ -0,0 +1,62 @@
+#pragma once
+#include "EncounterTemplate.h"
+
+#include <utility>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief An EncounterSampler counts every valid composition of monster levels for an xp window and draws from them uniformly.
+ *
+ * A composition is how many monsters of each level offset are fielded. The counts come from a dynamic program over
+ * (level offset, unique monsters left, total monsters left, xp so far), so nothing is ever enumerated and
+ * drawing a composition only walks the level offsets once.
+ */
+class EncounterSampler
+{
+public:
+    /**
+     * \brief Builds the counts for the given monster levels and limits.
+     * \param levelOffsetXps Level offsets that monsters may have and the xp each of them rewards.
+     * \param lowXp Lowest xp a composition may reward.
+     * \param highXp Highest xp a composition may reward.
+     * \param numUniqueMonsters Maximum number of different level offsets in a composition.
+     * \param numTotalMonsters Maximum number of monsters in a composition.
+     */
+    EncounterSampler(const std::vector<std::pair<int32_t, uint32_t>>& levelOffsetXps, const uint32_t& lowXp, const uint32_t& highXp, const uint32_t& numUniqueMonsters, const uint32_t& numTotalMonsters);
+    ~EncounterSampler() = default;
+
+    /**
+     * \brief Gets the number of valid compositions.
+     * \return Number of valid compositions.
+     */
+    uint64_t getNumCompositions() const;
+
+    /**
+     * \brief Gets one of the valid compositions. Every index gives a different composition.
+     * \param index Index of the composition, must be less than getNumCompositions().
+     * \return The composition at the given index.
+     */
+    EncounterTemplate getComposition(uint64_t index) const;
+
+private:
+    /**
+     * \brief Number of ways to finish a composition.
+     * \param item First level offset that may still be added.
+     * \param numUnique Number of new level offsets that may still be added.
+     * \param numTotal Number of monsters that may still be added.
+     * \param xp Xp of the composition so far.
+     * \return Number of valid compositions that start with the current one.
+     */
+    uint64_t getNumWays(size_t item, uint32_t numUnique, uint32_t numTotal, uint32_t xp) const;
+
+    size_t getWaysIndex(size_t item, uint32_t numUnique, uint32_t numTotal, uint32_t xp) const;
+
+    std::vector<std::pair<int32_t, uint32_t>> mLevelOffsetXps;
+    uint32_t mLowXp;
+    uint32_t mHighXp;
+    uint32_t mNumUniqueMonsters;
+    uint32_t mNumTotalMonsters;
+    std::vector<uint64_t> mNumWays;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "Encounter.h"
+
+#include <utility>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief An EncounterTemplate is an encounter whose monster levels are stored relative to the adventurer level.
+ *
+ * The xp of a monster only depends on how far its level is from the adventurers, so one template describes the same encounter for every party level.
+ */
+class EncounterTemplate
+{
+public:
+    EncounterTemplate() = default;
+    ~EncounterTemplate() = default;
+
+    /**
+     * \brief Add monsters to this template.
+     * \param levelOffset Level of the monsters relative to the adventurer level.
+     * \param numMonsters The number of monsters you want to add.
+     */
+    void addMonsters(int32_t levelOffset, uint32_t numMonsters);
+
+    /**
+     * \brief Get the level offsets that are in this template and how many monsters there are of each, in increasing offset order.
+     * \return Level offset and monster count pairs of this template.
+     */
+    const std::vector<std::pair<int32_t, uint32_t>>& getMonsterGroups() const;
+
+    /**
+     * \brief Get the total number of monsters in this template.
+     * \return Number of total monsters in this template.
+     */
+    uint32_t getNumTotalMonsters() const;
+
+    /**
+     * \brief Turns this template into an encounter for adventurers of the given level.
+     * \param adventurerLevel Level of the adventurers.
+     * \return Encounter with every level offset moved to the adventurer level.
+     */
+    Encounter toEncounter(const int32_t& adventurerLevel) const;
+
+private:
+    std::vector<std::pair<int32_t, uint32_t>> mMonsterGroups;
+    uint32_t mNumTotalMonsters{};
+};
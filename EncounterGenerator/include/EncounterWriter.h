@@ -0,0 +1,104 @@
+#pragma once
+#include "FilledEncounter.h"
+#include "GeneratorUtilities.h"
+#include "StringView.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace Pathfinder;
+
+/**
+ * \brief An EncounterWriter streams encounters out to a file as they are made, instead of building the whole file in memory first.
+ *
+ * Text goes into a reused buffer that is written out a block at a time, so memory stays the same however many rows are written.
+ * Blocks can be written on a background thread while the next one fills up. Once anything fails to write, the writer stays failed.
+ */
+class EncounterWriter
+{
+public:
+    static const size_t DEFAULT_BLOCK_SIZE;
+
+    /**
+     * \brief Opens the given file for writing, replacing what was there. Check isGood to see if it opened.
+     * \param filePath Path of the file that is to be written.
+     * \param writeInBackground If full blocks should be written on a background thread.
+     * \param blockSize Number of bytes to gather before writing them out.
+     */
+    EncounterWriter(const std::string& filePath, bool writeInBackground, size_t blockSize = DEFAULT_BLOCK_SIZE);
+    EncounterWriter(const EncounterWriter& other) = delete;
+    EncounterWriter& operator=(const EncounterWriter& other) = delete;
+
+    /**
+     * \brief Closes the file, writing out anything still buffered.
+     */
+    ~EncounterWriter();
+
+    /**
+     * \brief Add text to the file.
+     * \param text Text to add.
+     */
+    void write(const StringView& text);
+
+    /**
+     * \brief Add an encounter to the file as a csv row of the form "{Row},{Difficulty},{Encounter csv}". Rows are numbered from 1.
+     * \param difficulty Difficulty the encounter was made for.
+     * \param encounter Encounter to add.
+     */
+    void writeEncounter(const Difficulty& difficulty, const FilledEncounter& encounter);
+
+    /**
+     * \brief Write out everything added so far and wait for it to reach the file.
+     * \return If everything so far was written.
+     */
+    bool flush();
+
+    /**
+     * \brief Write out everything added so far and close the file. Nothing can be added after.
+     * \return If everything was written.
+     */
+    bool close();
+
+    /**
+     * \brief If the file opened and everything handed to it so far was written without an error.
+     * \return If no writes have failed.
+     */
+    bool isGood() const;
+
+private:
+    /**
+     * \brief Hand the buffer off to be written, leaving an empty buffer to keep filling.
+     */
+    void submitBuffer();
+
+    /**
+     * \brief Write a block to the file, noting if it failed.
+     * \param block Bytes to write.
+     */
+    void writeBlock(const std::string& block);
+
+    /**
+     * \brief Writes each block handed over by submitBuffer until the writer closes.
+     */
+    void writerLoop();
+
+    std::ofstream mFile;
+    size_t mBlockSize;
+    bool mIsOpen;
+    std::atomic<bool> mHasFailed;
+    uint32_t mNumEncounters;
+
+    std::string mBuffer;
+
+    // Handed from the filling thread to the background thread. Only touched by the background thread while mHasPendingBlock is set.
+    std::string mPendingBlock;
+    bool mHasPendingBlock;
+    bool mStopping;
+    std::mutex mStateMutex;
+    std::condition_variable mStateChanged;
+    std::thread mWriterThread;
+};
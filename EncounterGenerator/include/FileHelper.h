@@ -7,13 +7,36 @@ class FileHelper
 {
 public:
     /**
-     * \brief Parses the given json file into a monster list. 
+     * \brief Parses the given json file into a monster list. The file is streamed, so only one monster is held in memory at a time before it is added.
      * \param jsonPath Path to the json file containing monster info.
      * \param parseUnique If unique monsters should be added to the list.
      * \return MonsterList formed from the info in the json file.
      */
     static MonsterList parseJson(const std::string& jsonPath, bool parseUnique);
 
+    /**
+     * \brief Parses the given csv file into a monster list. The file is mapped into memory and split in place, so fields aren't copied on the way in.
+     * \param csvPath Path to the csv file containing monster info. Its first row names the columns, the same as the keys of the json file.
+     * \param parseUnique If unique monsters should be added to the list.
+     * \return MonsterList formed from the info in the csv file. Empty if the file is missing or doesn't have every column.
+     */
+    static MonsterList parseCsv(const std::string& csvPath, bool parseUnique);
+
+    /**
+     * \brief Loads a binary monster catalog by mapping it into memory. Nothing is parsed or copied, the list uses the catalog in place.
+     * \param catalogPath Path to the catalog, as written by writeCatalog.
+     * \return MonsterList of the monsters in the catalog. Empty if the catalog is missing or was written by another version.
+     */
+    static MonsterList loadCatalog(const std::string& catalogPath);
+
+    /**
+     * \brief Writes the given monster list, with its level and trait index, to a binary monster catalog.
+     * \param monsterList Monsters to write.
+     * \param catalogPath Path of the catalog that is to be written.
+     * \return If the catalog was written.
+     */
+    static bool writeCatalog(const MonsterList& monsterList, const std::string& catalogPath);
+
     /**
      * \brief Writes the given string to the given filepath.
      * \param filePath Path of the file that is to be written.
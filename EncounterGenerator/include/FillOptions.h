@@ -0,0 +1,60 @@
+#pragma once
+#include "GeneratorUtilities.h"
+
+using namespace Pathfinder;
+
+/**
+ * \brief How likely monsters of each rarity are to be picked when filling an encounter, relative to each other.
+ *
+ * A rarity weighed 0 is never picked from a pool that has anything else in it. A pool with nothing but such monsters picks evenly.
+ */
+struct RarityWeights
+{
+    double common{ 1.0 };
+    double uncommon{ 1.0 };
+    double rare{ 1.0 };
+    double unique{ 1.0 };
+
+    /**
+     * \brief Get the weight of a rarity. Anything that isn't a known rarity is weighed as common.
+     * \param rarity Rarity to get the weight of.
+     * \return Weight of the rarity.
+     */
+    double getWeight(const Rarity& rarity) const
+    {
+        switch (rarity)
+        {
+        case Rarity::Uncommon: return uncommon;
+        case Rarity::Rare: return rare;
+        case Rarity::Unique: return unique;
+        default: return common;
+        }
+    }
+
+    /**
+     * \brief If every rarity is as likely as the others, so monsters can be picked without looking at rarity at all.
+     * \return If all the weights are the same.
+     */
+    bool isUniform() const
+    {
+        return common == uncommon && common == rare && common == unique;
+    }
+
+    bool operator==(const RarityWeights& other) const
+    {
+        return common == other.common && uncommon == other.uncommon && rare == other.rare && unique == other.unique;
+    }
+    bool operator!=(const RarityWeights& other) const { return !(*this == other); }
+};
+
+/**
+ * \brief Options for filling encounters with monsters. The defaults fill encounters the same way they always have been.
+ */
+struct FillOptions
+{
+    RarityWeights rarityWeights;
+
+    // Pick each monster after the first as the one whose traits are most like all the monsters picked so far, instead of by one shared trait.
+    // Themed picks ignore the rarity weights.
+    bool isThemed{ false };
+};
@@ -1,27 +1,72 @@
 #pragma once
 
+#include "Encounter.h"
 #include "GeneratorUtilities.h"
 #include "Monster.h"
+#include "MonsterTable.h"
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
 
 using namespace Pathfinder;
 
 /**
  * \brief A filled encounter is a grouping of monsters describing one encounter for a party of adventurers.
+ *
+ * Monsters are stored inline as ids into one monster table with a count each, sorted the same way as Monster::operator<,
+ * along with the xp and monster counts, so a filled encounter never allocates and is cheap to copy, compare and hash.
  */
 class FilledEncounter
 {
 public:
+    /**
+     * \brief Most kinds of monster a filled encounter holds. Filling an encounter picks one kind per level, so this matches Encounter.
+     */
+    static constexpr uint32_t MAX_MONSTER_GROUPS = Encounter::MAX_MONSTER_LEVELS;
+
+    /**
+     * \brief A number of monsters that are all the same monster.
+     */
+    struct MonsterCount
+    {
+        MonsterId monsterId;
+        uint16_t count;
+    };
+
     FilledEncounter(const int32_t& adventurerLevel);
+
+    /**
+     * \brief Creates an empty encounter for monsters of the given table.
+     * \param adventurerLevel Level of the adventurers.
+     * \param monsterTable Table every monster of the encounter comes from.
+     */
+    FilledEncounter(const int32_t& adventurerLevel, const std::shared_ptr<const MonsterTable>& monsterTable);
     ~FilledEncounter() = default;
 
+    bool operator==(const FilledEncounter& other) const;
+    bool operator!=(const FilledEncounter& other) const;
+
     /**
      * \brief Add monsters to this encounter.
+     *
+     * A monster from another table than the one of this encounter is copied, along with every monster already added, into a table of the encounter's own.
+     * New kinds of monster are not added once the encounter already holds MAX_MONSTER_GROUPS kinds, and a kind never holds more than 65535 monsters.
      * \param monster A monster present in this encounter
      * \param numMonsters The number of monsters you want to add.
+     * \return If every monster was added. False if the kind of monster didn't fit or only some of the monsters did.
      */
-    void addMonsters(const Monster& monster, uint32_t numMonsters);
+    bool addMonsters(const Monster& monster, uint32_t numMonsters);
+
+    /**
+     * \brief Add monsters of the table of this encounter to this encounter.
+     * \param monsterId Id of the monster in the table of this encounter.
+     * \param numMonsters The number of monsters you want to add.
+     * \return If every monster was added. False if the encounter has no table, the kind of monster didn't fit or only some of the monsters did.
+     */
+    bool addMonsters(MonsterId monsterId, uint32_t numMonsters);
 
     /**
      * \brief Remove monsters from this encounter.
@@ -32,10 +77,36 @@ public:
 
     /**
      * \brief Get the monster Crs that are in this encounter and how many of them there are.
+     *
+     * Builds a new map on every call, prefer iterating over the encounter.
      * \return Monster CR map of this encounter.
      */
     std::map<Monster, uint32_t> getMonsterMap() const;
 
+    /**
+     * \brief Iterate over the monsters of this encounter in increasing level order, then by name.
+     * \return First monster count of this encounter.
+     */
+    const MonsterCount* begin() const;
+
+    /**
+     * \brief Iterate over the monsters of this encounter in increasing level order, then by name.
+     * \return One past the last monster count of this encounter.
+     */
+    const MonsterCount* end() const;
+
+    /**
+     * \brief Gets the table the monsters of this encounter come from.
+     * \return Table of the monsters. Null until a monster is added, unless the encounter was made with a table. A table of the encounter's own once monsters of several tables are added.
+     */
+    const std::shared_ptr<const MonsterTable>& getMonsterTable() const;
+
+    /**
+     * \brief Gets the level of adventurers involved in this encounter.
+     * \return Level of adventurers involved in this encounter.
+     */
+    int32_t getEncounterLevel() const;
+
     /**
      * \brief Get the number of unique monsters in this encounter.
      * \return Number of unique monsters in this encounter.
@@ -54,6 +125,12 @@ public:
      */
     uint32_t getEncounterXp() const;
 
+    /**
+     * \brief Hashes the adventurer level and monsters of this encounter.
+     * \return Hash of this encounter.
+     */
+    size_t hash() const;
+
     /**
      * \brief Converts the current encounter into a string.
      *
@@ -62,6 +139,12 @@ public:
      */
     std::string toString() const;
 
+    /**
+     * \brief Adds the string form of the current encounter to the end of a buffer, in the same form as toString.
+     * \param buffer Buffer to add to. Reusing one buffer for many encounters saves making a string for each.
+     */
+    void appendString(std::string& buffer) const;
+
     /**
      * \brief Converts the current encounter into a string in csv format.
      *
@@ -70,8 +153,47 @@ public:
      */
     std::string toCsvString() const;
 
+    /**
+     * \brief Adds the csv form of the current encounter to the end of a buffer, in the same form as toCsvString.
+     * \param buffer Buffer to add to. Reusing one buffer for many encounters saves making a string for each.
+     */
+    void appendCsvString(std::string& buffer) const;
+
 private:
+    /**
+     * \brief Orders a monster of the table of this encounter and a monster of any table like Monster::operator<.
+     * \param monsterId Id of the monster in the table of this encounter.
+     * \param otherTable Table of the other monster, which can be the table of this encounter.
+     * \param otherId Id of the other monster.
+     * \return Negative, zero or positive if the first monster sorts before, the same as or after the second.
+     */
+    int compareMonsters(MonsterId monsterId, const MonsterTable& otherTable, MonsterId otherId) const;
+
+    /**
+     * \brief Finds the group of a monster, or where it would go.
+     * \param monsterTable Table of the monster, which can be the table of this encounter.
+     * \param monsterId Id of the monster.
+     * \return First group that does not sort before the monster.
+     */
+    MonsterCount* findGroup(const MonsterTable& monsterTable, MonsterId monsterId);
+
+    std::shared_ptr<const MonsterTable> mMonsterTable;
     int32_t mAdventurerLevel;
-    std::map<Monster, uint32_t> mMonsterMap;
+    uint32_t mEncounterXp;
+    uint32_t mNumTotalMonsters;
+    uint32_t mNumUniqueMonsters;
+    std::array<MonsterCount, MAX_MONSTER_GROUPS> mMonsterCounts;
 
 };
+
+namespace std
+{
+    template <>
+    struct hash<FilledEncounter>
+    {
+        size_t operator()(const FilledEncounter& filledEncounter) const
+        {
+            return filledEncounter.hash();
+        }
+    };
+}
@@ -1,5 +1,13 @@
 #pragma once
+#include "RandomEngine.h"
+#include "StringView.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
 #include <map>
+#include <string>
 #include <vector>
 
 namespace Pathfinder
@@ -19,9 +27,9 @@ enum class Difficulty
 };
 
 /**
- * \brief Vector of all the difficulties.
+ * \brief Xp a monster rewards, indexed by its level minus the adventurer level, plus 7.
  */
-static const std::vector<uint32_t> MONSTER_XP_TABLE = {
+static constexpr std::array<uint32_t, 15> MONSTER_XP_TABLE = {{
     9,
     12,
     14,
@@ -37,8 +45,53 @@ static const std::vector<uint32_t> MONSTER_XP_TABLE = {
     108,
     135,
     160
+}};
+
+/**
+ * \brief Lowest and highest monster level minus adventurer level that rewards xp.
+ */
+static constexpr int32_t MIN_LEVEL_DELTA = -7;
+static constexpr int32_t MAX_LEVEL_DELTA = 7;
+
+/**
+ * \brief Highest level delta that xp is mapped back onto. The xp of a +7 monster maps onto a +6 monster.
+ */
+static constexpr int32_t MAX_MAPPED_LEVEL_DELTA = 6;
+
+/**
+ * \brief Lowest level a monster can have.
+ */
+static constexpr int32_t MIN_MONSTER_LEVEL = -1;
+
+/**
+ * \brief Maps every xp up to the highest in MONSTER_XP_TABLE onto the highest level delta whose monsters don't reward more.
+ */
+struct XpToLevelDeltaTable
+{
+    static constexpr int8_t NO_LEVEL_DELTA = INT8_MIN;
+    static constexpr uint32_t MAX_XP = 160;
+
+    constexpr XpToLevelDeltaTable() :
+        levelDeltas{}
+    {
+        for (uint32_t xp = 0; xp <= MAX_XP; ++xp)
+        {
+            levelDeltas[xp] = NO_LEVEL_DELTA;
+            for (auto levelDelta = MIN_LEVEL_DELTA; levelDelta <= MAX_MAPPED_LEVEL_DELTA; ++levelDelta)
+            {
+                if (MONSTER_XP_TABLE[levelDelta - MIN_LEVEL_DELTA] <= xp)
+                {
+                    levelDeltas[xp] = static_cast<int8_t>(levelDelta);
+                }
+            }
+        }
+    }
+
+    int8_t levelDeltas[MAX_XP + 1];
 };
 
+static constexpr XpToLevelDeltaTable XP_TO_LEVEL_DELTA_TABLE{};
+
 /**
  * \brief Vector of all the difficulties.
  */
@@ -51,15 +104,15 @@ static const std::vector<Difficulty> DIFFICULTY_VECTOR = {
 };
 
 /**
- * \brief XP budget for each adventurer at difficult 
+ * \brief XP budget for each adventurer, indexed by difficulty.
  */
-static const std::map<Difficulty, uint32_t> ADVENTURER_XP_BUDGET = {
-    {Difficulty::Trivial, 10},
-    {Difficulty::Low, 15},
-    {Difficulty::Moderate, 20},
-    {Difficulty::Severe, 30},
-    {Difficulty::Extreme, 40}
-};
+static constexpr std::array<uint32_t, 5> ADVENTURER_XP_BUDGET = {{
+    10, // Trivial
+    15, // Low
+    20, // Moderate
+    30, // Severe
+    40  // Extreme
+}};
 
 /**
  * \brief Allowed Sizes for all monsters.
@@ -75,6 +128,18 @@ enum class CreatureSize
     INVALID
 };
 
+/**
+ * \brief How rare a monster is.
+ */
+enum class Rarity
+{
+    Common = 0,
+    Uncommon,
+    Rare,
+    Unique,
+    INVALID
+};
+
 class GeneratorUtilities
 {
 public:
@@ -85,7 +150,20 @@ public:
      * \param monsterLevel Level of the monster
      * \return XP to award for defeating the monster for a given adventure level
      */
-    static uint32_t getMonsterXp(const int32_t &adventurerLevel, const int32_t &monsterLevel);
+    static constexpr uint32_t getMonsterXp(const int32_t &adventurerLevel, const int32_t &monsterLevel)
+    {
+        return monsterLevel < MIN_MONSTER_LEVEL ? 0 : getLevelDeltaXp(monsterLevel - adventurerLevel);
+    }
+
+    /**
+     * \brief Gets the xp that a monster rewards from how far its level is from the adventurers, ignoring the lowest monster level.
+     * \param levelDelta Level of the monster minus the level of the adventurer.
+     * \return XP to award for defeating the monster.
+     */
+    static constexpr uint32_t getLevelDeltaXp(const int32_t& levelDelta)
+    {
+        return (levelDelta < MIN_LEVEL_DELTA || levelDelta > MAX_LEVEL_DELTA) ? 0 : MONSTER_XP_TABLE[levelDelta - MIN_LEVEL_DELTA];
+    }
 
     /**
      * \brief Gets the level of a monster from how much xp it awards.
@@ -93,7 +171,40 @@ public:
      * \param xp XP of the monster.
      * \return Level of the monster with the given XP reward. If no exact match is found, finds the nearest, by flooring.
      */
-    static int32_t getMonsterLevel(const int32_t& adventurerLevel, const uint32_t &xp);
+    static constexpr int32_t getMonsterLevel(const int32_t& adventurerLevel, const uint32_t &xp)
+    {
+        // Deltas that would put the monster below the lowest level can't be fielded, and neither can any lower delta.
+        const int32_t levelDelta = XP_TO_LEVEL_DELTA_TABLE.levelDeltas[xp < XpToLevelDeltaTable::MAX_XP ? xp : XpToLevelDeltaTable::MAX_XP];
+        return (levelDelta == XpToLevelDeltaTable::NO_LEVEL_DELTA || adventurerLevel + levelDelta < MIN_MONSTER_LEVEL) ? -1 : adventurerLevel + levelDelta;
+    }
+
+    /**
+     * \brief Gets the xp that each of the given monsters will reward.
+     * \param adventurerLevel Level of the adventurer.
+     * \param monsterLevels Levels of the monsters.
+     * \param monsterXps Filled with the xp of each monster.
+     * \param numMonsters Number of monsters.
+     */
+    static void getMonsterXp(const int32_t& adventurerLevel, const int32_t* monsterLevels, uint32_t* monsterXps, size_t numMonsters);
+
+    /**
+     * \brief Gets the level of each of the given monsters from how much xp they award.
+     * \param adventurerLevel Level of the adventurer.
+     * \param monsterXps XP of the monsters.
+     * \param monsterLevels Filled with the level of each monster, see getMonsterLevel.
+     * \param numMonsters Number of monsters.
+     */
+    static void getMonsterLevel(const int32_t& adventurerLevel, const uint32_t* monsterXps, int32_t* monsterLevels, size_t numMonsters);
+
+    /**
+     * \brief Gets the xp budget of a single adventurer for a battle of the given difficulty.
+     * \param difficulty Difficulty of the battle.
+     * \return XP budget of one adventurer, 0 for invalid difficulties.
+     */
+    static constexpr uint32_t getAdventurerXpBudget(const Difficulty& difficulty)
+    {
+        return (difficulty < Difficulty::Trivial || difficulty > Difficulty::Extreme) ? 0 : ADVENTURER_XP_BUDGET[static_cast<size_t>(difficulty)];
+    }
 
     /**
      * \brief Turns the given difficulty into its string representation.
@@ -123,6 +234,20 @@ public:
      */
     static CreatureSize fromStringCreatureSize(const std::string &creatureSizeString);
 
+    /**
+     * \brief Turns the given rarity into its string representation.
+     * \param rarity Rarity to turn into a string.
+     * \return String representation of the rarity.
+     */
+    static std::string toStringRarity(const Rarity &rarity);
+
+    /**
+     * \brief Finds the rarity from the given string.
+     * \param rarityString String representation of a rarity.
+     * \return Rarity found from the given string. If no match is found, returns INVALID.
+     */
+    static Rarity fromStringRarity(const std::string &rarityString);
+
     /**
      * \brief Turns the given vector of traits into a semicolon divided string representation.
      * \param creatureTraits Vector of traits.
@@ -130,6 +255,20 @@ public:
      */
     static std::string toStringCreatureTraits(const std::vector<std::string> &creatureTraits);
 
+    /**
+     * \brief Adds a whole number to the end of a buffer in decimal, without making a string for it first.
+     * \param buffer Buffer to add to.
+     * \param value Number to add.
+     */
+    static void appendInteger(std::string &buffer, const int64_t &value);
+
+    /**
+     * \brief Gets the position of the lowest set bit of a word.
+     * \param word Word to look at. Must not be 0.
+     * \return Position of the lowest set bit.
+     */
+    static uint32_t getLowestSetBit(const uint64_t &word);
+
     /**
      * \brief Splits the given string representation of creature traits by dividing semicolons.
      * \param creatureTraitsString String representation of a creature traits divided by semicolons.
@@ -137,13 +276,24 @@ public:
      */
     static std::vector<std::string> fromStringCreatureTraits(const std::string &creatureTraitsString);
 
-private:
+    /**
+     * \brief Splits the given string representation of creature traits by dividing semicolons, without copying any of it.
+     * \param creatureTraitsString String representation of a creature traits divided by semicolons.
+     * \param creatureTraits Filled with views of the traits inside the given string.
+     */
+    static void fromStringCreatureTraits(const StringView &creatureTraitsString, std::vector<StringView> &creatureTraits);
 
     /**
-     * \brief Generates a map that pairs the xp a monster would award to its level.
-     * \param adventurerLevel Level of the adventurer.
-     * \return Map of monster xp to monster level.
+     * \brief Picks indices in a random order without repeating any, using a partial Fisher-Yates shuffle.
+     *
+     * Only the picked positions are shuffled, so this costs O(numSamples) rather than O(populationSize).
+     * If asking for more than the population, the shuffled population is looped over.
+     * \param populationSize Number of indices to pick from.
+     * \param numSamples Number of indices to pick.
+     * \param engine Random engine to pick with. The same engine state always picks the same indices, whatever the standard library.
+     * \return Picked indices.
      */
-    static std::map<uint32_t, int32_t> generateXpToLevelMap(const int32_t& adventurerLevel);
+    static std::vector<size_t> sampleIndices(size_t populationSize, size_t numSamples, RandomEngine& engine);
+
 };
 }
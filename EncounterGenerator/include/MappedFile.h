@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * \brief A MappedFile maps a whole file read only into memory.
+ *
+ * Pages are only read from disk when first touched, and every process mapping the same file shares the same pages.
+ */
+class MappedFile
+{
+public:
+    /**
+     * \brief Maps the given file. Check isOpen to see if it worked.
+     * \param filePath Path of the file to map.
+     */
+    explicit MappedFile(const std::string& filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * \brief If the file was mapped. Missing and empty files can't be.
+     * \return If the file is mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * \brief Gets the contents of the file.
+     * \return First byte of the file, or null if it isn't mapped.
+     */
+    const char* data() const;
+
+    /**
+     * \brief Gets the size of the file.
+     * \return Number of bytes in the file, or 0 if it isn't mapped.
+     */
+    size_t size() const;
+
+private:
+    const char* mData{};
+    size_t mSize{};
+
+    // Only used on Windows, where the mapping has to be closed along with the view.
+    void* mMappingHandle{};
+};
@@ -1,17 +1,23 @@
 #pragma once
+#include <memory>
 #include <string>
 
 #include "GeneratorUtilities.h"
+#include "MonsterTable.h"
 
 using namespace Pathfinder;
 
 /**
  * \brief A Monster is a creature used in encounters. It stores useful information about the creature and where to find more info.
+ *
+ * A Monster is a view of one row of a MonsterTable, so copying one only copies a pointer and an id.
  */
 class Monster
 {
 public:
-    Monster(const std::string& name, const int32_t& level, const CreatureSize& creatureSize, const std::vector<std::string>& creatureTraits, const std::string& location);
+    Monster(const std::string& name, const int32_t& level, const CreatureSize& creatureSize, const std::vector<std::string>& creatureTraits, const std::string& location,
+        const Rarity& rarity = Rarity::Common);
+    Monster(const std::shared_ptr<const MonsterTable>& monsterTable, const MonsterId& monsterId);
     Monster(const Monster& other) = default;
     ~Monster() = default;
 
@@ -42,6 +48,12 @@ public:
      */
     CreatureSize getCreatureSize() const;
 
+    /**
+     * \brief Gets the rarity of the monster.
+     * \return Rarity of the monster.
+     */
+    Rarity getRarity() const;
+
     /**
      * \brief Gets the creature traits of the monster.
      * \return Creature traits of the monster
@@ -60,10 +72,19 @@ public:
      */
     std::string getLocation() const;
 
+    /**
+     * \brief Gets the table this monster is stored in.
+     * \return Table of the monster.
+     */
+    const std::shared_ptr<const MonsterTable>& getMonsterTable() const;
+
+    /**
+     * \brief Gets the id of this monster in its table.
+     * \return Id of the monster.
+     */
+    MonsterId getMonsterId() const;
+
 private:
-    std::string mName;
-    int32_t mLevel;
-    CreatureSize mCreatureSize;
-    std::vector<std::string> mCreatureTraits;
-    std::string mLocation;
+    std::shared_ptr<const MonsterTable> mMonsterTable;
+    MonsterId mMonsterId;
 };
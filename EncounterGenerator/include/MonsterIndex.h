@@ -0,0 +1,134 @@
+#pragma once
+#include "CatalogReader.h"
+#include "CatalogWriter.h"
+#include "Column.h"
+#include "MonsterTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief A MonsterIndex groups the ids of a table of monsters by level and by creature trait.
+ *
+ * The ids are stored in one level sorted array with an offset per level into it, so a level lookup is two reads and never allocates.
+ * Every trait gets a bitmap over the positions of that array, so the monsters of one level with one trait are the set bits of a slice of one bitmap.
+ */
+class MonsterIndex
+{
+public:
+    MonsterIndex() = default;
+
+    /**
+     * \brief Index the monsters of the given table. Only reads the level, variant and trait columns.
+     * \param monsterTable Monsters to index.
+     */
+    explicit MonsterIndex(const MonsterTable& monsterTable);
+    ~MonsterIndex() = default;
+
+    /**
+     * \brief Get the ids of every monster of the given level, in the order they were added.
+     * \param level Level of the monsters.
+     * \return Ids of the monsters of that level. Empty if there are none.
+     */
+    MonsterIdSpan getMonstersOfLevel(const int32_t& level) const;
+
+    /**
+     * \brief Get the ids of every monster of the given level that has the given trait, in the order they were added.
+     * \param level Level of the monsters.
+     * \param traitId Trait the monsters must have.
+     * \param monsterIds Filled with the ids of the matching monsters.
+     */
+    void getMonstersOfLevelWithTrait(const int32_t& level, TraitId traitId, std::vector<MonsterId>& monsterIds) const;
+
+    /**
+     * \brief Get the ids of every monster of the given level that has the given trait, in the order they were added.
+     *
+     * Each level and trait is only worked out the first time it is asked for and kept after that, so later calls are one atomic read.
+     * Safe to call from several threads at once.
+     * \param level Level of the monsters.
+     * \param traitId Trait the monsters must have.
+     * \return Ids of the matching monsters. Stays valid for as long as the index does.
+     */
+    MonsterIdSpan getMonstersOfLevelWithTrait(const int32_t& level, TraitId traitId) const;
+
+    /**
+     * \brief Get the nearest level at or below the given one that has any monsters. Levels above the index fall back to its highest level.
+     * \param level Level that is wanted.
+     * \param fallbackLevel Set to the level that was found.
+     * \return If there was a level with monsters at or below the given one.
+     */
+    bool getFallbackLevel(const int32_t& level, int32_t& fallbackLevel) const;
+
+    /**
+     * \brief Get the lowest level that has any monsters.
+     * \return Lowest level in the index. Meaningless if the index is empty.
+     */
+    int32_t getMinLevel() const;
+
+    /**
+     * \brief Get the highest level that has any monsters.
+     * \return Highest level in the index. Meaningless if the index is empty.
+     */
+    int32_t getMaxLevel() const;
+
+    /**
+     * \brief Get the number of monsters in the index.
+     * \return Number of monsters.
+     */
+    uint32_t size() const;
+
+    /**
+     * \brief Get the number of traits the index has a bitmap for.
+     * \return Number of traits.
+     */
+    uint32_t getNumTraits() const;
+
+    /**
+     * \brief Add the index to a catalog.
+     * \param writer Catalog to add the index to.
+     */
+    void writeCatalog(CatalogWriter& writer) const;
+
+    /**
+     * \brief Replace the index with one read from a catalog. The offsets, ids, bitmaps and fallback levels are used in place.
+     * \param reader Catalog to read the index from.
+     * \return If the index was read. The index is left as it was if it wasn't.
+     */
+    bool readCatalog(CatalogReader& reader);
+
+private:
+    static const uint32_t BITS_PER_WORD = 64;
+
+    /**
+     * \brief Fill in the fallback level of every level. Worked out from the level offsets.
+     */
+    void buildFallbackLevels();
+
+    /**
+     * \brief Make an empty slot for every level and trait that can be asked for with getMonstersOfLevelWithTrait.
+     */
+    void resetLevelTraitPools();
+
+    int32_t mMinLevel{};
+    int32_t mMaxLevel{ -1 };
+
+    // mLevelOffsets[level - mMinLevel] is where that level starts in mMonsterIds, the next entry is where it ends.
+    Column<uint32_t> mLevelOffsets;
+    Column<MonsterId> mMonsterIds;
+
+    uint32_t mNumTraits{};
+
+    // One bitmap of mPositionWords words per trait, with bit p set if the monster at mMonsterIds[p] has the trait.
+    uint32_t mPositionWords{};
+    Column<uint64_t> mTraitBitmaps;
+
+    // An entry per level holding the nearest level at or below it with monsters. Entries below mMinLevel mean there is no such level.
+    Column<int32_t> mFallbackLevels;
+
+    // Monsters of each level with each trait, at mLevelTraitPools[traitId * number of levels + level - mMinLevel].
+    // Filled in the first time they are asked for and never replaced after, so spans into them stay valid.
+    mutable std::vector<std::shared_ptr<const std::vector<MonsterId>>> mLevelTraitPools;
+};
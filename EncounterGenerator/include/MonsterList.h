@@ -1,17 +1,38 @@
 #pragma once
 #include "Encounter.h"
+#include "FillOptions.h"
 #include "FilledEncounter.h"
 #include "Monster.h"
+#include "MonsterIndex.h"
+#include "MonsterQuery.h"
+#include "MonsterQueryIndex.h"
+#include "RandomEngine.h"
+#include "TraitSimilarityIndex.h"
+#include "WeightedMonsterPools.h"
+
+#include <array>
+#include <memory>
+#include <string>
 
 using namespace Pathfinder;
 
 /**
- * \brief A MonsterList is a wrapper around a vector of monsters with some helper methods for turning encounters into filled encounters.
+ * \brief A MonsterList is a wrapper around a table of monsters with some helper methods for turning encounters into filled encounters.
+ *
+ * Copies of a list share their table until one of them is changed.
  */
 class MonsterList
 {
 public:
     MonsterList();
+    explicit MonsterList(const std::shared_ptr<MonsterTable>& monsterTable);
+
+    /**
+     * \brief Creates a list from a table and an index that was already built over it.
+     * \param monsterTable Monsters of the list.
+     * \param monsterIndex Index over exactly those monsters.
+     */
+    MonsterList(const std::shared_ptr<MonsterTable>& monsterTable, const std::shared_ptr<const MonsterIndex>& monsterIndex);
     ~MonsterList() = default;
 
     /**
@@ -33,6 +54,26 @@ public:
      */
     FilledEncounter fillEncounter(const Encounter& encounter) const;
 
+    /**
+     * \brief Take a encounter and fill it up with monsters.
+     * \param encounter Encounter to fill up.
+     * \param engine Random engine to pick monsters with. The same engine state always picks the same monsters.
+     * \param options How to pick the monsters. Picks with rarity weights that aren't all the same use an alias table per pool, built the first time the pool is used.
+     * \return A filled encounter with monster.
+     */
+    FilledEncounter fillEncounter(const Encounter& encounter, RandomEngine& engine, const FillOptions& options = FillOptions()) const;
+
+    /**
+     * \brief Take a encounter and fill it up with monsters from the result of a query.
+     *
+     * Levels the result has nothing for use the nearest level below that it does, and monsters are matched on a shared trait the same as any other fill.
+     * \param encounter Encounter to fill up.
+     * \param candidates Monsters to choose from, made by queryMonsters on this list since it last changed.
+     * \param engine Random engine to pick monsters with. The same engine state always picks the same monsters.
+     * \return A filled encounter with monster.
+     */
+    FilledEncounter fillEncounter(const Encounter& encounter, const MonsterQueryResult& candidates, RandomEngine& engine) const;
+
     /**
      * \brief Take many encounters and fill them up with monsters.
      * \param encounters Encounters to fill up.
@@ -40,26 +81,109 @@ public:
      */
     std::vector<FilledEncounter> fillEncounters(const std::vector<Encounter>& encounters) const;
 
+    /**
+     * \brief Take many encounters and fill them up with monsters.
+     * \param encounters Encounters to fill up.
+     * \param engine Random engine to pick monsters with, used for the encounters in order. The same engine state always picks the same monsters.
+     * \param options How to pick the monsters.
+     * \return A vector of filled encounters.
+     */
+    std::vector<FilledEncounter> fillEncounters(const std::vector<Encounter>& encounters, RandomEngine& engine, const FillOptions& options = FillOptions()) const;
+
+    /**
+     * \brief Take many encounters and fill them up with monsters, spread over several threads.
+     *
+     * Every encounter picks from its own random stream, keyed by the seed and the position of the encounter,
+     * so the filled encounters are the same for any number of threads.
+     * \param encounters Encounters to fill up.
+     * \param seed Seed of the random streams. The same seed always picks the same monsters.
+     * \param numThreads Number of threads to fill with. 1 fills on the calling thread, 0 uses one per hardware thread.
+     * \param options How to pick the monsters.
+     * \return A vector of filled encounters, in the same order as the encounters.
+     */
+    std::vector<FilledEncounter> fillEncounters(const std::vector<Encounter>& encounters, const uint64_t& seed, const uint32_t& numThreads,
+        const FillOptions& options = FillOptions()) const;
+
+    /**
+     * \brief Find every monster of the list that matches a query.
+     *
+     * Answered from an index of the sizes, rarities and source books of the list, built on first use and rebuilt after the list changes.
+     * \param query Query to match.
+     * \return Ids of the monsters that match, sorted by level. Only meaningful until the list changes.
+     */
+    MonsterQueryResult queryMonsters(const MonsterQuery& query) const;
+
+    /**
+     * \brief Gets every source book the monsters of this list come from, for use in queries.
+     * \return Source books, sorted.
+     */
+    std::vector<std::string> getSourceBooks() const;
+
+    /**
+     * \brief Gets the table holding the monsters of this list.
+     * \return Table of the monsters.
+     */
+    std::shared_ptr<const MonsterTable> getMonsterTable() const;
+
 private:
+    static const size_t PARALLEL_FILL_CHUNK_SIZE;
+
+    /**
+     * \brief Gets the table for changing it, copying it first if anything else shares it.
+     * \return Table only this list holds.
+     */
+    MonsterTable& getMutableMonsterTable();
 
     /**
-     * \brief Filters the list of monsters by the given level.
-     * \param level Level to filter the monsters by.
-     * \return MonsterList consisting of only monsters of the given level.
+     * \brief Gets the level index of the monsters, building it if the list has changed since it was last built.
+     * \return Index over the current list of monsters.
      */
-    MonsterList filteredListByLevel(const int32_t& level) const;
+    std::shared_ptr<const MonsterIndex> getIndex() const;
+
     /**
-     * \brief Filters the list of monsters by the given creature type.
-     * \param creatureTrait Single trait of the monster to filter by.
-     * \return MonsterList consisting of only monsters of the given creature traits.
+     * \brief Gets the rarity weighted pools of the monsters, making new ones if the list or the weights have changed since they were last made.
+     * \param rarityWeights Weight of each rarity.
+     * \return Pools over the current list of monsters with the given weights.
      */
-    MonsterList filteredListByCreatureTrait(const std::string& creatureTrait) const;
+    std::shared_ptr<const WeightedMonsterPools> getWeightedPools(const RarityWeights& rarityWeights) const;
 
     /**
-     * \brief Gets a random monster from the list of available monsters.
-     * \return Random monster.
+     * \brief Gets the trait similarity index of the monsters, building it if the list has changed since it was last built.
+     * \return Similarity index over the current list of monsters.
      */
-    Monster getRandomMonster();
+    std::shared_ptr<const TraitSimilarityIndex> getSimilarityIndex() const;
+
+    /**
+     * \brief Gets the query index of the monsters, building it if the list has changed since it was last built.
+     * \return Query index over the current list of monsters.
+     */
+    std::shared_ptr<const MonsterQueryIndex> getQueryIndex() const;
+
+    /**
+     * \brief Gets the ids of the rarity traits. They say nothing about what kind of monster something is, so monsters are never matched on them.
+     * \return Ids of the Uncommon, Rare and Unique traits. INVALID_TRAIT for any the list doesn't have.
+     */
+    std::array<TraitId, 3> getRarityTraits() const;
+
+    /**
+     * \brief Gets a random monster from the given monsters.
+     * \param monsterIds Ids of the monsters to choose from. Must not be empty.
+     * \param engine Random engine to choose with.
+     * \return Id of a random monster.
+     */
+    static MonsterId getRandomMonster(const MonsterIdSpan& monsterIds, RandomEngine& engine);
+
+    std::shared_ptr<MonsterTable> mMonsterTable;
+
+    // Built on first use and dropped whenever the table changes. Copies of the list share it since their ids line up.
+    mutable std::shared_ptr<const MonsterIndex> mIndex;
+
+    // Made for the last weights asked for and dropped along with the index.
+    mutable std::shared_ptr<const WeightedMonsterPools> mWeightedPools;
+
+    // Built on first themed fill and dropped along with the index.
+    mutable std::shared_ptr<const TraitSimilarityIndex> mSimilarityIndex;
 
-    std::vector<Monster> mMonsters;
+    // Built on first query and dropped along with the index.
+    mutable std::shared_ptr<const MonsterQueryIndex> mQueryIndex;
 };
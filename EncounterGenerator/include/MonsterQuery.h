@@ -0,0 +1,88 @@
+#pragma once
+#include "GeneratorUtilities.h"
+#include "MonsterTable.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief A MonsterQuery describes which monsters of a list are wanted. A monster has to match every part of it.
+ *
+ * For example levels 3 to 6, Large or bigger, not Rare, from a few source books.
+ */
+struct MonsterQuery
+{
+    int32_t minLevel{ MIN_MONSTER_LEVEL };
+    int32_t maxLevel{ std::numeric_limits<int32_t>::max() };
+
+    // Any size if empty.
+    std::vector<CreatureSize> creatureSizes;
+
+    // Any rarity if empty.
+    std::vector<Rarity> rarities;
+
+    // Books the monsters come from, which is their location without the page, like "Bestiary 2" for "Bestiary 2 pg. 143". Any book if empty.
+    std::vector<std::string> sourceBooks;
+};
+
+/**
+ * \brief A MonsterQueryResult holds the ids of the monsters that matched a query, sorted by level.
+ *
+ * Ids are only meaningful for the list that was queried, and only until that list changes.
+ */
+class MonsterQueryResult
+{
+public:
+    MonsterQueryResult() = default;
+
+    /**
+     * \brief Creates a result from ids that are already sorted by level.
+     * \param minLevel Level of the first run of ids.
+     * \param levelOffsets Where the ids of each level from minLevel on start, with one more offset where the last level ends.
+     * \param monsterIds Ids of the monsters, sorted by level.
+     */
+    MonsterQueryResult(const int32_t& minLevel, std::vector<uint32_t> levelOffsets, std::vector<MonsterId> monsterIds);
+    ~MonsterQueryResult() = default;
+
+    /**
+     * \brief Get the ids of every monster that matched, sorted by level.
+     * \return Ids of the monsters. Valid for as long as this result is.
+     */
+    MonsterIdSpan getMonsters() const;
+
+    /**
+     * \brief Get the ids of every monster of the given level that matched.
+     * \param level Level of the monsters.
+     * \return Ids of the monsters. Empty if there are none. Valid for as long as this result is.
+     */
+    MonsterIdSpan getMonstersOfLevel(const int32_t& level) const;
+
+    /**
+     * \brief Get the nearest level at or below the given one that has any monsters that matched.
+     * \param level Level that is wanted.
+     * \param fallbackLevel Set to the level that was found.
+     * \return If there was a level with monsters at or below the given one.
+     */
+    bool getFallbackLevel(const int32_t& level, int32_t& fallbackLevel) const;
+
+    /**
+     * \brief Get the number of monsters that matched.
+     * \return Number of monsters.
+     */
+    size_t size() const;
+
+    /**
+     * \brief If no monsters matched.
+     * \return If there are no monsters.
+     */
+    bool empty() const;
+
+private:
+    int32_t mMinLevel{};
+    std::vector<uint32_t> mLevelOffsets;
+    std::vector<MonsterId> mMonsterIds;
+};
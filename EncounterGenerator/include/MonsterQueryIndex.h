@@ -0,0 +1,99 @@
+#pragma once
+#include "MonsterIndex.h"
+#include "MonsterQuery.h"
+#include "MonsterTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief A MonsterQueryIndex answers MonsterQuerys over a list of monsters without looking at the monsters themselves.
+ *
+ * Monsters sit in the level sorted order of a MonsterIndex, so a level range is one run of positions. Every creature size, rarity
+ * and source book has a bitmap over those positions, along with how many monsters of each level have it. A query ORs together
+ * the bitmaps each part of it allows, and ANDs the parts word by word, starting from the part that the counts say matches the fewest monsters,
+ * so most words are done with after the first part.
+ */
+class MonsterQueryIndex
+{
+public:
+    /**
+     * \brief Index the sizes, rarities and source books of a table of monsters.
+     * \param monsterTable Monsters to index.
+     * \param monsterIndex Level index over those monsters.
+     */
+    MonsterQueryIndex(const MonsterTable& monsterTable, const std::shared_ptr<const MonsterIndex>& monsterIndex);
+    ~MonsterQueryIndex() = default;
+
+    /**
+     * \brief Find every monster that matches a query.
+     * \param query Query to match.
+     * \return Ids of the monsters that match, sorted by level and then in the order they were added.
+     */
+    MonsterQueryResult query(const MonsterQuery& query) const;
+
+    /**
+     * \brief Get every source book of the indexed monsters.
+     * \return Source books, sorted.
+     */
+    const std::vector<std::string>& getSourceBooks() const;
+
+    /**
+     * \brief Get the source book of a location, which is the location without its page.
+     * \param location Location of a monster, like "Bestiary 2 pg. 143".
+     * \return Source book of the location, like "Bestiary 2".
+     */
+    static std::string getSourceBook(const std::string& location);
+
+private:
+    static const uint32_t BITS_PER_WORD = 64;
+    static const uint32_t NUM_SIZE_ROWS = static_cast<uint32_t>(CreatureSize::INVALID) + 1;
+    static const uint32_t NUM_RARITY_ROWS = static_cast<uint32_t>(Rarity::INVALID) + 1;
+
+    /**
+     * \brief The bitmaps one part of a query allows, and about how many monsters they hold in the levels asked for.
+     */
+    struct Predicate
+    {
+        std::vector<uint32_t> rows;
+        uint64_t numMatches;
+    };
+
+    /**
+     * \brief Turn one part of a query into the rows of bitmaps it allows.
+     * \param rows Rows the part allows. Not a predicate at all if empty, since that part allows anything.
+     * \param firstSlot First level slot asked for.
+     * \param lastSlot Last level slot asked for.
+     * \param predicates Filled with the predicate, if the part is one.
+     */
+    void addPredicate(std::vector<uint32_t> rows, size_t firstSlot, size_t lastSlot, std::vector<Predicate>& predicates) const;
+
+    /**
+     * \brief ORs together the rows of a predicate at one word.
+     * \param predicate Predicate to look at.
+     * \param wordIndex Word of the bitmaps.
+     * \return Bits of that word allowed by the predicate.
+     */
+    uint64_t getPredicateWord(const Predicate& predicate, uint32_t wordIndex) const;
+
+    std::shared_ptr<const MonsterIndex> mMonsterIndex;
+    int32_t mMinLevel{};
+    int32_t mMaxLevel{ -1 };
+
+    // mLevelOffsets[level - mMinLevel] is the first position of that level, the next entry is where it ends.
+    std::vector<uint32_t> mLevelOffsets;
+
+    // Sorted. The row of a book is NUM_SIZE_ROWS + NUM_RARITY_ROWS plus its place here.
+    std::vector<std::string> mSourceBooks;
+
+    // One bitmap of mPositionWords words per row, sizes first, then rarities, then source books.
+    uint32_t mPositionWords{};
+    std::vector<uint64_t> mBitmaps;
+
+    // Number of monsters of each level in each row, at mRunCounts[row * number of levels + level - mMinLevel].
+    std::vector<uint32_t> mRunCounts;
+};
@@ -0,0 +1,335 @@
+#pragma once
+#include "CatalogReader.h"
+#include "CatalogWriter.h"
+#include "Column.h"
+#include "GeneratorUtilities.h"
+#include "StringPool.h"
+#include "StringView.h"
+#include "TraitDictionary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief Identifies a monster in a table: which record it comes from and which variant of that record it is.
+ */
+typedef uint32_t MonsterId;
+
+/**
+ * \brief An IdSpan is a non-owning view over a contiguous run of ids.
+ *
+ * It is only valid for as long as whatever owns the ids is alive and unchanged.
+ */
+template<typename Id>
+class IdSpan
+{
+public:
+    IdSpan() = default;
+    IdSpan(const Id* first, const Id* last) : mFirst{ first }, mLast{ last } {}
+
+    const Id* begin() const { return mFirst; }
+    const Id* end() const { return mLast; }
+    size_t size() const { return static_cast<size_t>(mLast - mFirst); }
+    bool empty() const { return mFirst == mLast; }
+    const Id& operator[](size_t index) const { return mFirst[index]; }
+
+private:
+    const Id* mFirst{};
+    const Id* mLast{};
+};
+
+typedef IdSpan<MonsterId> MonsterIdSpan;
+typedef IdSpan<TraitId> TraitIdSpan;
+
+/**
+ * \brief Adjustment applied on top of a monster record.
+ */
+enum class MonsterVariant
+{
+    Base = 0,
+    Weak,
+    Elite,
+    INVALID
+};
+
+/**
+ * \brief A MonsterTable stores a catalog of monsters column by column.
+ *
+ * Every field of a record lives in its own array, so a scan over one field never touches the others.
+ * Names and locations are kept in a single string pool, and traits are interned ids with a bitmask per record.
+ * Weak and Elite monsters are not stored. They are variants of a record, told apart by their MonsterId, and their level and name are worked out when asked for.
+ * A table read from a catalog uses the columns of the catalog in place until it is changed.
+ */
+class MonsterTable
+{
+public:
+    MonsterTable() = default;
+    ~MonsterTable() = default;
+
+    /**
+     * \brief Makes the id of a variant of a record.
+     * \param record Index of the record.
+     * \param variant Variant of the record.
+     * \return Id of the monster.
+     */
+    static MonsterId makeMonsterId(uint32_t record, const MonsterVariant& variant);
+
+    /**
+     * \brief Gets the record a monster comes from.
+     * \param monsterId Id of the monster.
+     * \return Index of the record.
+     */
+    static uint32_t getRecord(MonsterId monsterId);
+
+    /**
+     * \brief Gets which variant of its record a monster is.
+     * \param monsterId Id of the monster.
+     * \return Variant of the monster.
+     */
+    static MonsterVariant getVariant(MonsterId monsterId);
+
+    /**
+     * \brief Add a record to the end of the table, with only its base monster.
+     * \param name Name of the monster.
+     * \param level Level of the monster.
+     * \param creatureSize Size of the monster.
+     * \param rarity Rarity of the monster.
+     * \param creatureTraits Traits of the monster.
+     * \param location Where to find more info on the monster.
+     * \return Id of the new monster.
+     */
+    MonsterId addMonster(const std::string& name, const int32_t& level, const CreatureSize& creatureSize, const Rarity& rarity,
+        const std::vector<std::string>& creatureTraits, const std::string& location);
+
+    /**
+     * \brief Add a record to the end of the table, with only its base monster. The text is copied straight out of the views into the table.
+     * \param name Name of the monster.
+     * \param level Level of the monster.
+     * \param creatureSize Size of the monster.
+     * \param rarity Rarity of the monster.
+     * \param creatureTraits Traits of the monster.
+     * \param location Where to find more info on the monster.
+     * \return Id of the new monster.
+     */
+    MonsterId addMonster(const StringView& name, const int32_t& level, const CreatureSize& creatureSize, const Rarity& rarity,
+        const std::vector<StringView>& creatureTraits, const StringView& location);
+
+    /**
+     * \brief Add a copy of a monster from another table to the end of this table, as a new record with only that variant.
+     * \param other Table the monster is in, which can be this table.
+     * \param otherId Id of the monster in the other table.
+     * \return Id of the new monster in this table.
+     */
+    MonsterId addMonster(const MonsterTable& other, MonsterId otherId);
+
+    /**
+     * \brief Makes another variant of a record part of the table. Does nothing if it already is.
+     * \param monsterId Id of any monster of the record.
+     * \param variant Variant to add.
+     * \return Id of the added variant.
+     */
+    MonsterId addVariant(MonsterId monsterId, const MonsterVariant& variant);
+
+    /**
+     * \brief Get the number of monsters in the table, counting every variant.
+     * \return Number of monsters.
+     */
+    uint32_t size() const;
+
+    /**
+     * \brief Get the number of records in the table.
+     * \return Number of records.
+     */
+    uint32_t getNumRecords() const;
+
+    /**
+     * \brief Get the id of every monster in the table, record by record with the variants of a record in order.
+     * \return Ids of the monsters.
+     */
+    std::vector<MonsterId> getMonsterIds() const;
+
+    /**
+     * \brief If a variant of a record is part of the table.
+     * \param record Index of the record.
+     * \param variant Variant of the record.
+     * \return If the variant is part of the table.
+     */
+    bool hasVariant(uint32_t record, const MonsterVariant& variant) const;
+
+    /**
+     * \brief Gets the name of a monster, with the variant in front of it.
+     * \param monsterId Id of the monster.
+     * \return Name of the monster.
+     */
+    std::string getName(MonsterId monsterId) const;
+
+    /**
+     * \brief Adds the name of a monster, with the variant in front of it, to the end of a buffer.
+     * \param monsterId Id of the monster.
+     * \param buffer Buffer to add to.
+     */
+    void appendName(MonsterId monsterId, std::string& buffer) const;
+
+    /**
+     * \brief Gets the level of a monster, with the variant adjustment applied.
+     * \param monsterId Id of the monster.
+     * \return Level of the monster.
+     */
+    int32_t getLevel(MonsterId monsterId) const;
+
+    /**
+     * \brief Gets the creature size of a monster.
+     * \param monsterId Id of the monster.
+     * \return Creature size of the monster.
+     */
+    CreatureSize getCreatureSize(MonsterId monsterId) const;
+
+    /**
+     * \brief Gets the rarity of a monster.
+     * \param monsterId Id of the monster.
+     * \return Rarity of the monster.
+     */
+    Rarity getRarity(MonsterId monsterId) const;
+
+    /**
+     * \brief Gets the location of a monster.
+     * \param monsterId Id of the monster.
+     * \return Location of the monster.
+     */
+    std::string getLocation(MonsterId monsterId) const;
+
+    /**
+     * \brief Adds the location of a monster to the end of a buffer.
+     * \param monsterId Id of the monster.
+     * \param buffer Buffer to add to.
+     */
+    void appendLocation(MonsterId monsterId, std::string& buffer) const;
+
+    /**
+     * \brief Get the traits of a monster, in the order the monster lists them.
+     * \param monsterId Id of the monster.
+     * \return Ids of the traits of the monster.
+     */
+    TraitIdSpan getCreatureTraits(MonsterId monsterId) const;
+
+    /**
+     * \brief Adds the traits of a monster to the end of a buffer, each followed by a semicolon like GeneratorUtilities::toStringCreatureTraits.
+     * \param monsterId Id of the monster.
+     * \param buffer Buffer to add to.
+     */
+    void appendCreatureTraits(MonsterId monsterId, std::string& buffer) const;
+
+    /**
+     * \brief If the monster has the given trait.
+     * \param monsterId Id of the monster.
+     * \param traitId Id of the trait.
+     * \return If the monster has the given trait.
+     */
+    bool hasCreatureTrait(MonsterId monsterId, TraitId traitId) const;
+
+    /**
+     * \brief Get the dictionary every trait in this table was interned into.
+     * \return Trait dictionary of this table.
+     */
+    const TraitDictionary& getTraitDictionary() const;
+
+    /**
+     * \brief Get the level of every record before any variant adjustment, indexed by record.
+     * \return Base level column.
+     */
+    const Column<int32_t>& getBaseLevels() const;
+
+    /**
+     * \brief Get the size of every record, indexed by record.
+     * \return Creature size column.
+     */
+    const Column<CreatureSize>& getCreatureSizes() const;
+
+    /**
+     * \brief Get the rarity of every record, indexed by record.
+     * \return Rarity column.
+     */
+    const Column<Rarity>& getRarities() const;
+
+    /**
+     * \brief Compares the names of two monsters, variant included, like std::string::compare.
+     * \param monsterId Id of the monster in this table.
+     * \param other Table of the other monster, which can be this table.
+     * \param otherId Id of the other monster.
+     * \return Negative, zero or positive if this name sorts before, the same as or after the other name.
+     */
+    int compareNames(MonsterId monsterId, const MonsterTable& other, MonsterId otherId) const;
+
+    /**
+     * \brief Checks if every field of two monsters but their rarity is the same.
+     * \param monsterId Id of the monster in this table.
+     * \param other Table of the other monster, which can be this table.
+     * \param otherId Id of the other monster.
+     * \return If the two monsters are the same.
+     */
+    bool isSameMonster(MonsterId monsterId, const MonsterTable& other, MonsterId otherId) const;
+
+    /**
+     * \brief Add the table to a catalog.
+     * \param writer Catalog to add the table to.
+     */
+    void writeCatalog(CatalogWriter& writer) const;
+
+    /**
+     * \brief Replace the table with one read from a catalog. The columns are used in place.
+     * \param reader Catalog to read the table from.
+     * \return If the table was read. The table is left as it was if it wasn't.
+     */
+    bool readCatalog(CatalogReader& reader);
+
+private:
+    /**
+     * \brief Add a record to the end of the table without any of its variants.
+     * \param name Name of the monster.
+     * \param level Level of the monster.
+     * \param creatureSize Size of the monster.
+     * \param rarity Rarity of the monster.
+     * \param creatureTraits Traits of the monster.
+     * \param location Where to find more info on the monster.
+     * \return Index of the new record.
+     */
+    uint32_t addRecord(const StringView& name, const int32_t& level, const CreatureSize& creatureSize, const Rarity& rarity,
+        const std::vector<StringView>& creatureTraits, const StringView& location);
+
+    /**
+     * \brief Intern a trait, widening every trait mask if it is the first trait that does not fit in them.
+     * \param trait Trait to intern.
+     * \return Id of the trait.
+     */
+    TraitId internTrait(const StringView& trait);
+
+    static const uint32_t BITS_PER_WORD = 64;
+    static const uint32_t VARIANT_BITS = 2;
+
+    uint32_t mNumMonsters{};
+
+    Column<int32_t> mBaseLevels;
+    Column<CreatureSize> mCreatureSizes;
+    Column<Rarity> mRarities;
+
+    // Bit v is set if MonsterVariant v of the record is part of the table.
+    Column<uint8_t> mVariants;
+
+    StringPool mStrings;
+    Column<StringHandle> mNames;
+    Column<StringHandle> mLocations;
+
+    TraitDictionary mTraitDictionary;
+
+    // Traits of a record are mTraitIds[mTraitOffsets[record]] up to mTraitIds[mTraitOffsets[record + 1]].
+    Column<uint32_t> mTraitOffsets{ 0 };
+    Column<TraitId> mTraitIds;
+
+    // One bitmask of mTraitMaskWords words per record, with bit t set if the record has trait t.
+    uint32_t mTraitMaskWords{};
+    Column<uint64_t> mTraitMasks;
+};
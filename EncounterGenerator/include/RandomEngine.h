@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+/**
+ * \brief A RandomEngine is a small, fast, seedable xoshiro256** random number generator.
+ *
+ * The same seed always gives the same numbers on every platform, so anything drawn with one can be replayed.
+ * It works with the standard distributions, but nextBelow gives results that don't depend on the standard library.
+ */
+class RandomEngine
+{
+public:
+    typedef uint64_t result_type;
+
+    /**
+     * \brief Creates an engine from a seed.
+     * \param seed Seed of the engine. Any value is fine, including 0.
+     */
+    explicit RandomEngine(uint64_t seed);
+    ~RandomEngine() = default;
+
+    /**
+     * \brief Restarts the engine from a seed.
+     * \param seed Seed of the engine.
+     */
+    void seed(uint64_t seed);
+
+    /**
+     * \brief Gets the next random number.
+     * \return Uniformly distributed 64 bit number.
+     */
+    result_type operator()();
+
+    /**
+     * \brief Gets a random number below the given bound, without any modulo bias.
+     * \param bound One past the largest number wanted. Must not be 0.
+     * \return Uniformly distributed number in [0, bound).
+     */
+    uint64_t nextBelow(uint64_t bound);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    /**
+     * \brief Creates an engine for one of many independent streams that share a seed.
+     *
+     * The starting state is a Philox4x32-10 block of the stream index keyed by the seed, so any stream can be made on its own, in any order, on any thread.
+     * \param seed Seed shared by every stream.
+     * \param streamIndex Index of the stream.
+     * \return Engine at the start of the stream.
+     */
+    static RandomEngine fromStream(uint64_t seed, uint64_t streamIndex);
+
+    /**
+     * \brief Gets the engine of the calling thread, for callers that don't bring their own.
+     *
+     * It is seeded once per thread from std::random_device, so its results can't be replayed.
+     * \return Engine of the calling thread.
+     */
+    static RandomEngine& getThreadEngine();
+
+private:
+    explicit RandomEngine(const std::array<uint64_t, 4>& state);
+
+    std::array<uint64_t, 4> mState;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include "CatalogReader.h"
+#include "CatalogWriter.h"
+#include "Column.h"
+#include "StringView.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Handle of a string stored in a StringPool.
+ */
+typedef uint32_t StringHandle;
+
+/**
+ * \brief A StringPool stores many strings back to back in a single buffer instead of one allocation each.
+ */
+class StringPool
+{
+public:
+    StringPool();
+    ~StringPool() = default;
+
+    /**
+     * \brief Copy a string into the pool.
+     * \param string String to add.
+     * \return Handle of the string. Handles are handed out in order starting at 0.
+     */
+    StringHandle add(const StringView& string);
+
+    /**
+     * \brief Get a copy of a string in the pool.
+     * \param handle Handle of the string. Must have come from this pool.
+     * \return The string.
+     */
+    std::string get(StringHandle handle) const;
+
+    /**
+     * \brief Get the characters of a string in the pool. They are not null terminated.
+     * \param handle Handle of the string. Must have come from this pool.
+     * \return Pointer to the first character of the string.
+     */
+    const char* data(StringHandle handle) const;
+
+    /**
+     * \brief Get a view of a string in the pool, without copying it.
+     * \param handle Handle of the string. Must have come from this pool.
+     * \return View of the string. Valid until the pool is changed.
+     */
+    StringView getView(StringHandle handle) const;
+
+    /**
+     * \brief Get the length of a string in the pool.
+     * \param handle Handle of the string. Must have come from this pool.
+     * \return Number of characters in the string.
+     */
+    uint32_t length(StringHandle handle) const;
+
+    /**
+     * \brief Compares a string in this pool with a string in another pool, like std::string::compare.
+     * \param handle Handle of the string in this pool.
+     * \param other Pool of the other string, which can be this pool.
+     * \param otherHandle Handle of the string in the other pool.
+     * \return Negative, zero or positive if this string sorts before, the same as or after the other string.
+     */
+    int compare(StringHandle handle, const StringPool& other, StringHandle otherHandle) const;
+
+    /**
+     * \brief Compares a string in this pool with some characters, like std::string::compare.
+     * \param handle Handle of the string in this pool.
+     * \param characters Characters to compare with. They don't need to be null terminated.
+     * \param length Number of characters.
+     * \return Negative, zero or positive if this string sorts before, the same as or after the characters.
+     */
+    int compare(StringHandle handle, const char* characters, size_t length) const;
+
+    /**
+     * \brief Get the number of strings in the pool.
+     * \return Number of strings.
+     */
+    uint32_t size() const;
+
+    /**
+     * \brief Add the pool to a catalog.
+     * \param writer Catalog to add the pool to.
+     */
+    void writeCatalog(CatalogWriter& writer) const;
+
+    /**
+     * \brief Replace the pool with one read from a catalog. The strings are used in place.
+     * \param reader Catalog to read the pool from.
+     * \return If the pool was read.
+     */
+    bool readCatalog(CatalogReader& reader);
+
+private:
+    Column<char> mCharacters;
+
+    // String handle spans mCharacters from mOffsets[handle] up to mOffsets[handle + 1].
+    Column<uint32_t> mOffsets;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/**
+ * \brief A StringView is a non-owning view over a run of characters, so text can be passed around and split without copying it.
+ *
+ * It is only valid for as long as whatever owns the characters is alive and unchanged.
+ */
+class StringView
+{
+public:
+    StringView() = default;
+    StringView(const char* characters, size_t length) : mCharacters{ characters }, mLength{ length } {}
+    StringView(const char* characters) : mCharacters{ characters }, mLength{ std::strlen(characters) } {}
+    StringView(const std::string& string) : mCharacters{ string.data() }, mLength{ string.size() } {}
+
+    const char* data() const { return mCharacters; }
+    size_t size() const { return mLength; }
+    bool empty() const { return mLength == 0; }
+    const char* begin() const { return mCharacters; }
+    const char* end() const { return mCharacters + mLength; }
+    const char& operator[](size_t index) const { return mCharacters[index]; }
+
+    /**
+     * \brief Copies the characters into a string.
+     * \return The characters as a string.
+     */
+    std::string toString() const { return std::string(mCharacters, mLength); }
+
+    bool operator==(const StringView& other) const
+    {
+        return mLength == other.mLength && (mLength == 0 || std::memcmp(mCharacters, other.mCharacters, mLength) == 0);
+    }
+    bool operator!=(const StringView& other) const { return !(*this == other); }
+
+private:
+    const char* mCharacters{ "" };
+    size_t mLength{};
+};
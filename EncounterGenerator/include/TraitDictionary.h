@@ -0,0 +1,87 @@
+#pragma once
+#include "CatalogReader.h"
+#include "CatalogWriter.h"
+#include "Column.h"
+#include "StringPool.h"
+#include "StringView.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief Small integer standing in for a creature trait string.
+ */
+typedef uint32_t TraitId;
+
+/**
+ * \brief A TraitDictionary hands out one id per distinct creature trait so traits can be compared and stored as integers.
+ *
+ * Traits are found by a binary search over the ids sorted by trait, which needs nothing rebuilt when the dictionary comes from a catalog.
+ */
+class TraitDictionary
+{
+public:
+    static const TraitId INVALID_TRAIT = UINT32_MAX;
+
+    TraitDictionary() = default;
+    ~TraitDictionary() = default;
+
+    /**
+     * \brief Get the id of a trait, adding it to the dictionary if it has not been seen before.
+     * \param trait Trait to intern.
+     * \return Id of the trait. Ids are handed out in order starting at 0.
+     */
+    TraitId intern(const StringView& trait);
+
+    /**
+     * \brief Get the id of a trait without adding it.
+     * \param trait Trait to look for.
+     * \return Id of the trait, or INVALID_TRAIT if it is not in the dictionary.
+     */
+    TraitId find(const StringView& trait) const;
+
+    /**
+     * \brief Get the trait behind an id.
+     * \param traitId Id of the trait. Must have come from this dictionary.
+     * \return Trait string of the id.
+     */
+    std::string getTrait(TraitId traitId) const;
+
+    /**
+     * \brief Get a view of the trait behind an id, without copying it.
+     * \param traitId Id of the trait. Must have come from this dictionary.
+     * \return View of the trait. Valid until the dictionary is changed.
+     */
+    StringView getTraitView(TraitId traitId) const;
+
+    /**
+     * \brief Get the number of distinct traits in the dictionary.
+     * \return Number of traits.
+     */
+    uint32_t size() const;
+
+    /**
+     * \brief Add the dictionary to a catalog.
+     * \param writer Catalog to add the dictionary to.
+     */
+    void writeCatalog(CatalogWriter& writer) const;
+
+    /**
+     * \brief Replace the dictionary with one read from a catalog. The traits are used in place.
+     * \param reader Catalog to read the dictionary from.
+     * \return If the dictionary was read.
+     */
+    bool readCatalog(CatalogReader& reader);
+
+private:
+    /**
+     * \brief Find where a trait is, or would go, in the sorted ids.
+     * \param trait Trait to look for.
+     * \return Position of the first id whose trait does not sort before the given trait.
+     */
+    size_t lowerBound(const StringView& trait) const;
+
+    // Trait id t is string handle t of the pool.
+    StringPool mTraits;
+    Column<TraitId> mSortedTraitIds;
+};
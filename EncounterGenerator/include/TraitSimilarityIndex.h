@@ -0,0 +1,94 @@
+#pragma once
+#include "MonsterIndex.h"
+#include "MonsterTable.h"
+#include "RandomEngine.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief A TraitSimilarityIndex finds the monsters of a level whose creature traits are most like a given set of traits.
+ *
+ * Every monster gets a MinHash signature of its traits, cut into bands that are each hashed into a bucket, kept apart per level.
+ * Monsters of the level that share a bucket with the wanted traits in any band are likely to be similar, so only they are compared exactly,
+ * instead of every monster of the level.
+ */
+class TraitSimilarityIndex
+{
+public:
+    static const uint32_t NUM_BANDS = 16;
+    static const uint32_t ROWS_PER_BAND = 2;
+    static const uint32_t SIGNATURE_SIZE = NUM_BANDS * ROWS_PER_BAND;
+
+    TraitSimilarityIndex() = default;
+
+    /**
+     * \brief Index the traits of every monster of a table.
+     * \param monsterTable Monsters to index.
+     * \param monsterIndex Level index over those monsters.
+     * \param ignoredTraits Traits that say nothing about what a monster is, which are left out of every comparison.
+     */
+    TraitSimilarityIndex(const MonsterTable& monsterTable, const MonsterIndex& monsterIndex, const std::vector<TraitId>& ignoredTraits);
+    ~TraitSimilarityIndex() = default;
+
+    /**
+     * \brief Find the monster of a level whose traits are most alike to the given traits, by Jaccard similarity. Ties are picked at random.
+     *
+     * Monsters that share no bucket with the traits are never found, so a match that is only a little alike may be missed.
+     * \param level Level of the monster.
+     * \param traitIds Traits the monster should be like. Ignored traits are skipped.
+     * \param engine Random engine to break ties with.
+     * \param monsterId Set to the monster that was found.
+     * \return If a monster of the level that shares a bucket with the given traits was found. False when none do, even if some share a trait.
+     */
+    bool findMostSimilar(const int32_t& level, const std::vector<TraitId>& traitIds, RandomEngine& engine, MonsterId& monsterId) const;
+
+private:
+    typedef std::array<uint32_t, SIGNATURE_SIZE> Signature;
+
+    /**
+     * \brief Gets the MinHash signature of a set of traits.
+     * \param traitIds Traits to sign. Must not hold any ignored traits.
+     * \return Smallest hash of the traits under every hash function. All bits set if there are no traits.
+     */
+    static Signature getSignature(const std::vector<TraitId>& traitIds);
+
+    /**
+     * \brief Gets the bucket of one band of a signature.
+     * \param signature Signature of the monster.
+     * \param band Band of the signature.
+     * \return Key of the bucket.
+     */
+    static uint64_t getBucketKey(const Signature& signature, uint32_t band);
+
+    /**
+     * \brief Copies the traits that are not ignored, sorted and without repeats.
+     * \param traitIds Traits to copy.
+     * \param keptTraits Filled with the traits that are kept.
+     */
+    template<typename TraitRange>
+    void keepTraits(const TraitRange& traitIds, std::vector<TraitId>& keptTraits) const;
+
+    // Sorted.
+    std::vector<TraitId> mIgnoredTraits;
+
+    int32_t mMinLevel{};
+    int32_t mMaxLevel{ -1 };
+
+    // Every set of traits that isn't empty once ignored traits are left out is an entry per level it shows up at.
+    // An entry has its traits at mTraitOffsets[entry] up to the next offset, and the monsters with them at mMonsterOffsets[entry] up to the next offset.
+    // Entries are in level order, with mLevelOffsets[level - mMinLevel] where that level starts and the next offset where it ends.
+    std::vector<uint32_t> mTraitOffsets;
+    std::vector<TraitId> mEntryTraits;
+    std::vector<uint32_t> mMonsterOffsets;
+    std::vector<MonsterId> mEntryMonsters;
+    std::vector<uint32_t> mLevelOffsets;
+
+    // For each band, the bucket key of every entry sorted by key within each level, with the entry alongside.
+    // Band b is at [b * number of entries, (b + 1) * number of entries).
+    std::vector<uint64_t> mBucketKeys;
+    std::vector<uint32_t> mBucketEntries;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "AliasTable.h"
+#include "FillOptions.h"
+#include "MonsterIndex.h"
+#include "MonsterTable.h"
+#include "RandomEngine.h"
+
+#include <memory>
+#include <vector>
+
+using namespace Pathfinder;
+
+/**
+ * \brief WeightedMonsterPools picks monsters from the pools of a MonsterIndex in proportion to the weight of their rarity.
+ *
+ * Every level, and every level and trait, gets its own alias table the first time something is picked from it, so each pick after that takes the same time
+ * however big the pool is. The tables are read and filled with atomic shared_ptr operations, so picks can happen from several threads at once.
+ */
+class WeightedMonsterPools
+{
+public:
+    /**
+     * \brief Creates empty pools over an index. Only the rarities of the table are read, and only here.
+     * \param monsterIndex Index to pick from.
+     * \param monsterTable Table the index was built over.
+     * \param rarityWeights Weight of each rarity.
+     */
+    WeightedMonsterPools(const std::shared_ptr<const MonsterIndex>& monsterIndex, const MonsterTable& monsterTable, const RarityWeights& rarityWeights);
+    ~WeightedMonsterPools() = default;
+
+    /**
+     * \brief Gets the weights the pools were made with.
+     * \return Weight of each rarity.
+     */
+    const RarityWeights& getRarityWeights() const;
+
+    /**
+     * \brief Picks a random monster of a level.
+     * \param level Level of the monster. Must have monsters.
+     * \param engine Random engine to pick with.
+     * \return Id of the monster that was picked.
+     */
+    MonsterId getRandomMonsterOfLevel(const int32_t& level, RandomEngine& engine) const;
+
+    /**
+     * \brief Picks a random monster of a level that has a trait.
+     * \param level Level of the monster.
+     * \param traitId Trait the monster must have. The level must have monsters with it.
+     * \param engine Random engine to pick with.
+     * \return Id of the monster that was picked.
+     */
+    MonsterId getRandomMonsterOfLevelWithTrait(const int32_t& level, TraitId traitId, RandomEngine& engine) const;
+
+private:
+    /**
+     * \brief Gets the alias table of a pool, building it if this is the first time.
+     * \param slot Slot holding the table of the pool.
+     * \param monsterIds Monsters of the pool.
+     * \return Alias table over the monsters of the pool.
+     */
+    std::shared_ptr<const AliasTable> getAliasTable(std::shared_ptr<const AliasTable>& slot, const MonsterIdSpan& monsterIds) const;
+
+    std::shared_ptr<const MonsterIndex> mMonsterIndex;
+    RarityWeights mRarityWeights;
+    int32_t mMinLevel;
+    size_t mNumLevels;
+
+    // Weight of every record of the table. Variants share the rarity of their record.
+    std::vector<double> mRecordWeights;
+
+    // One slot per level, then one per level and trait at mLevelTraitTables[traitId * mNumLevels + level - mMinLevel].
+    mutable std::vector<std::shared_ptr<const AliasTable>> mLevelTables;
+    mutable std::vector<std::shared_ptr<const AliasTable>> mLevelTraitTables;
+};
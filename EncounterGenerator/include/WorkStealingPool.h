@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief A WorkStealingPool runs tasks on a fixed set of threads. Every thread has its own queue and steals from the others once it runs dry.
+ */
+class WorkStealingPool
+{
+public:
+    /**
+     * \brief Creates a pool that runs tasks on the given number of threads, including whichever thread waits on the pool.
+     * \param numThreads Number of threads to run tasks on. 0 uses one per hardware thread.
+     */
+    explicit WorkStealingPool(const uint32_t& numThreads);
+    WorkStealingPool(const WorkStealingPool& other) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool& other) = delete;
+    ~WorkStealingPool();
+
+    /**
+     * \brief Queues a task to be run. Tasks submitted from inside the pool go on the submitting thread's own queue.
+     * \param task Task to run.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * \brief Blocks until every submitted task has finished. The calling thread runs tasks while it waits.
+     */
+    void wait();
+
+    /**
+     * \brief Gets the number of threads that run tasks, including the waiting thread.
+     * \return Number of threads that run tasks.
+     */
+    uint32_t getNumThreads() const;
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /**
+     * \brief Runs one task, preferring the newest task of the given queue and otherwise stealing the oldest task of another.
+     * \param queueIndex Queue of the calling thread.
+     * \return If a task was run.
+     */
+    bool runTask(const size_t& queueIndex);
+
+    void workerLoop(const size_t& queueIndex);
+
+    std::vector<std::unique_ptr<TaskQueue>> mQueues;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mStateMutex;
+    std::condition_variable mStateChanged;
+    std::atomic<size_t> mNumQueuedTasks;
+    std::atomic<size_t> mNumUnfinishedTasks;
+    std::atomic<size_t> mNextQueue;
+    bool mStopping;
+};
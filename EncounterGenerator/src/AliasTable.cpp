@@ -0,0 +1,58 @@
+#include "AliasTable.h"
+
+#include <algorithm>
+
+AliasTable::AliasTable(const std::vector<double>& weights) :
+    mThresholds(weights.size(), UINT32_MAX),
+    mAliases(weights.size())
+{
+    const auto numPositions = weights.size();
+    double totalWeight = 0.0;
+    for (const auto& weight : weights)
+    {
+        totalWeight += std::max(weight, 0.0);
+    }
+
+    // Scale every weight so the average column is exactly 1, then split them into columns under and over that.
+    std::vector<double> scaledWeights(numPositions, 1.0);
+    std::vector<uint32_t> smallColumns;
+    std::vector<uint32_t> largeColumns;
+    for (uint32_t position = 0; position < numPositions; ++position)
+    {
+        if (totalWeight > 0.0)
+        {
+            scaledWeights[position] = std::max(weights[position], 0.0) * static_cast<double>(numPositions) / totalWeight;
+        }
+        mAliases[position] = position;
+        (scaledWeights[position] < 1.0 ? smallColumns : largeColumns).push_back(position);
+    }
+
+    // Top up each small column from a large one, which shrinks that large column by the same amount.
+    while (!smallColumns.empty() && !largeColumns.empty())
+    {
+        const auto smallColumn = smallColumns.back();
+        smallColumns.pop_back();
+        const auto largeColumn = largeColumns.back();
+        largeColumns.pop_back();
+
+        mThresholds[smallColumn] = static_cast<uint32_t>(std::min(scaledWeights[smallColumn] * 4294967296.0, 4294967295.0));
+        mAliases[smallColumn] = largeColumn;
+
+        scaledWeights[largeColumn] = (scaledWeights[largeColumn] + scaledWeights[smallColumn]) - 1.0;
+        (scaledWeights[largeColumn] < 1.0 ? smallColumns : largeColumns).push_back(largeColumn);
+    }
+
+    // Whatever is left over is only off from 1 by rounding, so those columns always keep themselves.
+}
+
+size_t AliasTable::size() const
+{
+    return mThresholds.size();
+}
+
+size_t AliasTable::sample(RandomEngine& engine) const
+{
+    const auto column = static_cast<size_t>(engine.nextBelow(mThresholds.size()));
+    const auto coin = static_cast<uint32_t>(engine() >> 32);
+    return coin < mThresholds[column] ? column : mAliases[column];
+}
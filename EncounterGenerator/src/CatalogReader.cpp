@@ -0,0 +1,87 @@
+#include "CatalogReader.h"
+#include "CatalogHeader.h"
+
+#include <cstring>
+
+CatalogReader::CatalogReader(const std::string& filePath) :
+    mFile{ std::make_shared<MappedFile>(filePath) }
+{
+    if (!mFile->isOpen() || mFile->size() < sizeof(CatalogHeader))
+    {
+        return;
+    }
+
+    CatalogHeader header;
+    std::memcpy(&header, mFile->data(), sizeof(header));
+    if (std::memcmp(header.magic, CATALOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CATALOG_VERSION ||
+        header.byteOrder != CATALOG_BYTE_ORDER ||
+        header.size != mFile->size())
+    {
+        return;
+    }
+
+    mPosition = sizeof(CatalogHeader);
+    mSize = header.size;
+    mIsValid = true;
+}
+
+bool CatalogReader::isValid() const
+{
+    return mIsValid;
+}
+
+bool CatalogReader::isAtEnd() const
+{
+    return mIsValid && mPosition == mSize;
+}
+
+bool CatalogReader::readValue(uint64_t& value)
+{
+    uint64_t count = 0;
+    const auto* values = readSection(count, sizeof(value));
+    if (values == nullptr || count != 1)
+    {
+        mIsValid = false;
+        return false;
+    }
+
+    std::memcpy(&value, values, sizeof(value));
+    return true;
+}
+
+const char* CatalogReader::readSection(uint64_t& count, uint64_t valueSize)
+{
+    const auto* sectionHeader = skip(2 * sizeof(uint64_t));
+    if (sectionHeader == nullptr)
+    {
+        return nullptr;
+    }
+
+    uint64_t sectionValueSize = 0;
+    std::memcpy(&count, sectionHeader, sizeof(count));
+    std::memcpy(&sectionValueSize, sectionHeader + sizeof(count), sizeof(sectionValueSize));
+
+    // A different value size means the catalog was written for other types, and a huge count would wrap the length.
+    if (sectionValueSize != valueSize || count > (mSize - mPosition) / valueSize)
+    {
+        mIsValid = false;
+        return nullptr;
+    }
+
+    return skip(count * valueSize);
+}
+
+const char* CatalogReader::skip(uint64_t length)
+{
+    const auto padding = (CATALOG_ALIGNMENT - length % CATALOG_ALIGNMENT) % CATALOG_ALIGNMENT;
+    if (!mIsValid || length > mSize - mPosition || padding > mSize - mPosition - length)
+    {
+        mIsValid = false;
+        return nullptr;
+    }
+
+    const auto* bytes = mFile->data() + mPosition;
+    mPosition += length + padding;
+    return bytes;
+}
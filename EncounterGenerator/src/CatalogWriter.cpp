@@ -0,0 +1,46 @@
+#include "CatalogWriter.h"
+#include "CatalogHeader.h"
+
+#include <cstring>
+#include <fstream>
+
+CatalogWriter::CatalogWriter() :
+    mBytes(sizeof(CatalogHeader), '\0')
+{
+}
+
+void CatalogWriter::writeValue(uint64_t value)
+{
+    writeSection(&value, 1, sizeof(value));
+}
+
+bool CatalogWriter::writeToFile(const std::string& filePath)
+{
+    CatalogHeader header;
+    std::memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+    header.version = CATALOG_VERSION;
+    header.byteOrder = CATALOG_BYTE_ORDER;
+    header.size = mBytes.size();
+    std::memcpy(&mBytes[0], &header, sizeof(header));
+
+    std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+    out.write(mBytes.data(), static_cast<std::streamsize>(mBytes.size()));
+    out.close();
+    return !out.fail();
+}
+
+void CatalogWriter::writeSection(const void* values, size_t count, size_t valueSize)
+{
+    const uint64_t sectionHeader[] = { count, valueSize };
+    append(sectionHeader, sizeof(sectionHeader));
+    append(values, count * valueSize);
+}
+
+void CatalogWriter::append(const void* bytes, size_t length)
+{
+    if (length != 0)
+    {
+        mBytes.append(static_cast<const char*>(bytes), length);
+    }
+    mBytes.append(static_cast<size_t>((CATALOG_ALIGNMENT - mBytes.size() % CATALOG_ALIGNMENT) % CATALOG_ALIGNMENT), '\0');
+}
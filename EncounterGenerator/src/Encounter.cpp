@@ -1,12 +1,51 @@
 #include "Encounter.h"
 
+#include <algorithm>
+#include <limits>
 #include <string>
+#include <type_traits>
 
 using namespace Pathfinder;
 
+static_assert(std::is_trivially_copyable<Encounter>::value, "Encounters are copied around in bulk and must stay trivially copyable.");
+
+constexpr uint32_t Encounter::MAX_MONSTER_LEVELS;
+
 Encounter::Encounter(const int32_t& adventurerLevel) :
-    mAdventurerLevel{adventurerLevel}
+    mAdventurerLevel{adventurerLevel},
+    mEncounterXp{0},
+    mNumTotalMonsters{0},
+    mNumUniqueMonsters{0},
+    mMonsterGroups{}
+{
+}
+
+bool Encounter::operator==(const Encounter& other) const
 {
+    return mAdventurerLevel == other.mAdventurerLevel
+        && mNumUniqueMonsters == other.mNumUniqueMonsters
+        && std::equal(begin(), end(), other.begin(), [](const MonsterGroup& group, const MonsterGroup& otherGroup)
+        {
+            return group.level == otherGroup.level && group.count == otherGroup.count;
+        });
+}
+
+bool Encounter::operator!=(const Encounter& other) const
+{
+    return !(*this == other);
+}
+
+bool Encounter::operator<(const Encounter& other) const
+{
+    if (mAdventurerLevel != other.mAdventurerLevel)
+    {
+        return mAdventurerLevel < other.mAdventurerLevel;
+    }
+
+    return std::lexicographical_compare(begin(), end(), other.begin(), other.end(), [](const MonsterGroup& group, const MonsterGroup& otherGroup)
+    {
+        return group.level != otherGroup.level ? group.level < otherGroup.level : group.count < otherGroup.count;
+    });
 }
 
 int32_t Encounter::getEncounterLevel() const
@@ -14,68 +53,132 @@ int32_t Encounter::getEncounterLevel() const
     return mAdventurerLevel;
 }
 
-void Encounter::addMonsters(int32_t level, uint32_t numMonsters)
+bool Encounter::addMonsters(int32_t level, uint32_t numMonsters)
 {
-    mMonsterLevelToCountMap[level] += numMonsters;
+    auto group = std::lower_bound(mMonsterGroups.begin(), mMonsterGroups.begin() + mNumUniqueMonsters, level,
+        [](const MonsterGroup& monsterGroup, int32_t groupLevel) { return monsterGroup.level < groupLevel; });
+
+    if (group == mMonsterGroups.begin() + mNumUniqueMonsters || group->level != level)
+    {
+        if (mNumUniqueMonsters == MAX_MONSTER_LEVELS)
+        {
+            return false;
+        }
+
+        // Shift the higher levels up one to keep the groups sorted.
+        std::move_backward(group, mMonsterGroups.begin() + mNumUniqueMonsters, mMonsterGroups.begin() + mNumUniqueMonsters + 1);
+        group->level = static_cast<int16_t>(level);
+        group->count = 0;
+        ++mNumUniqueMonsters;
+    }
+
+    // Counts are stored in 16 bits, far more monsters than any xp budget allows.
+    const auto numAdded = std::min<uint32_t>(numMonsters, std::numeric_limits<uint16_t>::max() - group->count);
+    group->count = static_cast<uint16_t>(group->count + numAdded);
+    mNumTotalMonsters += numAdded;
+    mEncounterXp += GeneratorUtilities::getMonsterXp(mAdventurerLevel, level) * numAdded;
+    return numAdded == numMonsters;
 }
 
 void Encounter::removeMonsters(int32_t level, uint32_t numMonsters)
 {
-    if(mMonsterLevelToCountMap.count(level) != 0)
+    auto group = std::find_if(mMonsterGroups.begin(), mMonsterGroups.begin() + mNumUniqueMonsters,
+        [level](const MonsterGroup& monsterGroup) { return monsterGroup.level == level; });
+
+    if (group == mMonsterGroups.begin() + mNumUniqueMonsters)
     {
-        if (mMonsterLevelToCountMap[level] <= numMonsters)
-        {
-            mMonsterLevelToCountMap.erase(level);
-        }
-        else
-        {
-            mMonsterLevelToCountMap[level] -= numMonsters;
-        }
+        return;
+    }
+
+    const auto numRemoved = std::min<uint32_t>(numMonsters, group->count);
+    mNumTotalMonsters -= numRemoved;
+    mEncounterXp -= GeneratorUtilities::getMonsterXp(mAdventurerLevel, level) * numRemoved;
+
+    if (group->count <= numMonsters)
+    {
+        std::move(group + 1, mMonsterGroups.begin() + mNumUniqueMonsters, group);
+        --mNumUniqueMonsters;
+        mMonsterGroups[mNumUniqueMonsters] = MonsterGroup{};
+    }
+    else
+    {
+        group->count = static_cast<uint16_t>(group->count - numRemoved);
     }
 }
 
 std::map<int32_t, uint32_t> Encounter::getMonsterLevelToCountMap() const
 {
-    return mMonsterLevelToCountMap;
+    std::map<int32_t, uint32_t> monsterLevelToCountMap;
+    for (const auto& monsterGroup : *this)
+    {
+        monsterLevelToCountMap[monsterGroup.level] = monsterGroup.count;
+    }
+    return monsterLevelToCountMap;
+}
+
+const Encounter::MonsterGroup* Encounter::begin() const
+{
+    return mMonsterGroups.data();
+}
+
+const Encounter::MonsterGroup* Encounter::end() const
+{
+    return mMonsterGroups.data() + mNumUniqueMonsters;
 }
 
 uint32_t Encounter::getNumUniqueMonsters() const
 {
-    return static_cast<uint32_t>(mMonsterLevelToCountMap.size());
+    return mNumUniqueMonsters;
 }
 
 uint32_t Encounter::getNumTotalMonsters() const
 {
-    auto numMonsters = 0;
-    for (const auto& levelNumPair : mMonsterLevelToCountMap)
-    {
-        numMonsters += levelNumPair.second;
-    }
-    return numMonsters;
+    return mNumTotalMonsters;
 }
 
 uint32_t Encounter::getEncounterXp() const
 {
-    auto battleXp = 0;
-    for (const auto &monsterGroup : mMonsterLevelToCountMap)
-    {
-        battleXp += GeneratorUtilities::getMonsterXp(mAdventurerLevel, monsterGroup.first) * monsterGroup.second;
-    }
-    return battleXp;
+    return mEncounterXp;
 }
 
-std::string Encounter::toString() const
+size_t Encounter::hash() const
 {
-    std::string encounterString = "";
-    for (auto monsterPair : mMonsterLevelToCountMap)
+    // FNV-1a over the adventurer level and every group.
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+
+    mix(static_cast<uint32_t>(mAdventurerLevel));
+    for (const auto& monsterGroup : *this)
     {
-        encounterString += std::to_string(monsterPair.second) + " level " + std::to_string(monsterPair.first) + " : ";
+        mix((static_cast<uint64_t>(static_cast<uint16_t>(monsterGroup.level)) << 16) | monsterGroup.count);
     }
-    // Get rid of the fence post stuff.
-    encounterString.pop_back();
-    encounterString.pop_back();
-    encounterString.pop_back();
+    return static_cast<size_t>(hash);
+}
 
+std::string Encounter::toString() const
+{
+    std::string encounterString;
+    appendString(encounterString);
     return encounterString;
 }
 
+void Encounter::appendString(std::string& buffer) const
+{
+    auto isFirst = true;
+    for (const auto& monsterPair : *this)
+    {
+        if (!isFirst)
+        {
+            buffer += " : ";
+        }
+        isFirst = false;
+
+        GeneratorUtilities::appendInteger(buffer, monsterPair.count);
+        buffer += " level ";
+        GeneratorUtilities::appendInteger(buffer, monsterPair.level);
+    }
+}
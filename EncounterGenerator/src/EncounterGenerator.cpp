@@ -1,83 +1,93 @@
 #include "EncounterGenerator.h"
 #include "Party.h"
-#include <random>
 #include <cassert>
-#include <chrono>
-#include <numeric>
+#include <mutex>
+#include <tuple>
 
 using namespace Pathfinder;
 
-EncounterGenerator::EncounterGenerator(const Party &adventurers, const uint32_t &numUniqueMonsters, const uint32_t& numTotalMonsters) :
+const uint32_t EncounterGenerator::PARALLEL_SPLIT_DEPTH = 2;
+
+EncounterGenerator::EncounterGenerator(const Party &adventurers, const uint32_t &numUniqueMonsters, const uint32_t& numTotalMonsters, const uint32_t& numThreads) :
     mParty(adventurers),
     mNumUniqueMonsters(numUniqueMonsters),
     mNumTotalMonsters(numTotalMonsters),
-    mValidBattles({})
+    mNumThreads(numThreads)
 {
     setMinimumMonsterXp();
     setMaximumMonsterXp();
-    fillOutEncounters();
 }
 
 std::vector<Encounter> EncounterGenerator::getEncounters(const Difficulty& difficulty, uint32_t numBattles) const
 {
-    auto battles = getAllEncounters(difficulty);
+    return getEncounters(difficulty, numBattles, RandomEngine::getThreadEngine());
+}
 
-    if(battles.empty() || numBattles == 0)
+std::vector<Encounter> EncounterGenerator::getEncounters(const Difficulty& difficulty, uint32_t numBattles, RandomEngine& engine) const
+{
+    const auto& battles = getAllEncounters(difficulty);
+
+    // Create the output battleVector.
+    std::vector<Encounter> outputBattles;
+    outputBattles.reserve(numBattles);
+
+    for (auto index : sampleEncounterIndices(difficulty, numBattles, engine))
     {
-        return {};
+        outputBattles.push_back(battles[index]);
     }
 
-    // Vectorize the battles we will be choosing from.
-    std::vector<Encounter> vectorizedBattles;
+    return outputBattles;
+}
 
-    for (const auto battle : battles)
+const std::vector<Encounter>& EncounterGenerator::getAllEncounters(const Difficulty& difficulty) const
+{
+    if(difficulty >= Difficulty::Trivial && difficulty < Difficulty::INVALID)
     {
-        vectorizedBattles.push_back(battle);
+        return getValidBattles(difficulty);
     }
 
-    // Create a selection vector that increases from 0 -> total number of battles - 1.
-    // Then shuffle it around so we have a pick without replacement vector.
-    std::vector<int> selectionVector(battles.size());
-    std::iota(std::begin(selectionVector), std::end(selectionVector), 0); // Fill with 0, 1, ..., 99.
-
-    // obtain a time-based seed:
-    auto seed = static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count());
-    std::shuffle(selectionVector.begin(), selectionVector.end(), std::default_random_engine(seed));
+    static const std::vector<Encounter> noBattles;
+    return noBattles;
+}
 
-    // Create the output battleVector.
-    std::vector<Encounter> outputBattles;
+std::vector<size_t> EncounterGenerator::sampleEncounterIndices(const Difficulty& difficulty, uint32_t numBattles, RandomEngine& engine) const
+{
+    return GeneratorUtilities::sampleIndices(getAllEncounters(difficulty).size(), numBattles, engine);
+}
 
-    // if we have less numBattles than the total num battles, we will never have repeats.
-    // If we loop over, just keep filling it so that we always get how many we ask for.
-    for(uint32_t i = 0; i < numBattles; i++)
+uint64_t EncounterGenerator::countEncounters(const Difficulty& difficulty) const
+{
+    if (mMinimumMonsterXp.count(difficulty) == 0)
     {
-        outputBattles.push_back(vectorizedBattles[selectionVector[i%selectionVector.size()]]);
+        return 0;
     }
 
-    return outputBattles;
+    return getSampler(getSearchKey(difficulty))->getNumCompositions();
 }
 
-std::vector<Encounter> EncounterGenerator::getAllEncounters(const Difficulty& difficulty) const
+std::vector<Encounter> EncounterGenerator::sampleEncounters(const Difficulty& difficulty, uint32_t numBattles) const
 {
-    if(mValidBattles.count(difficulty) != 0)
+    return sampleEncounters(difficulty, numBattles, RandomEngine::getThreadEngine());
+}
+
+std::vector<Encounter> EncounterGenerator::sampleEncounters(const Difficulty& difficulty, uint32_t numBattles, RandomEngine& engine) const
+{
+    const auto numCompositions = countEncounters(difficulty);
+    if (numCompositions == 0 || numBattles == 0)
     {
-        return mValidBattles.at(difficulty);
+        return {};
     }
 
-    return {};
-}
+    const auto sampler = getSampler(getSearchKey(difficulty));
 
-Encounter EncounterGenerator::convertMonsterVectorToEncounter(const std::vector<uint32_t>& monsterXpVector) const
-{
-    Encounter encounter(mParty.getLevel());
-    // Fill out the list so we can get the desired xp.
-    for (auto monsterXp : monsterXpVector)
+    std::vector<Encounter> outputBattles;
+    outputBattles.reserve(numBattles);
+    for (uint32_t i = 0; i < numBattles; i++)
     {
-        auto monsterLevel = GeneratorUtilities::getMonsterLevel(mParty.getLevel(), monsterXp);
-        encounter.addMonsters(monsterLevel, 1);
+        outputBattles.push_back(sampler->getComposition(engine.nextBelow(numCompositions)).toEncounter(mParty.getLevel()));
     }
 
-    return encounter;
+    return outputBattles;
 }
 
 std::vector<uint32_t> EncounterGenerator::getValidMonsterXPs(const uint32_t& minXp, const uint32_t& maxXp)
@@ -159,80 +169,328 @@ uint32_t EncounterGenerator::getMaximumMonsterXp(const Difficulty& difficulty) c
     return lastXp;
 }
 
-void EncounterGenerator::fillOutEncounters()
+EncounterGenerator::SearchKey EncounterGenerator::getSearchKey(const Difficulty& difficulty) const
+{
+    SearchKey key{};
+    key.lowXp = mParty.getLowerDesiredXp(difficulty);
+    key.highXp = mParty.getUpperDesiredXp(difficulty);
+    key.numUniqueMonsters = mNumUniqueMonsters;
+    key.numTotalMonsters = mNumTotalMonsters;
+
+    // When adding monsters into the map, add them in chunks that must make up at least 20% of allotted xp.
+    const auto minXpPerLevel = mParty.getDesiredXp(difficulty) / 5;
+    const auto partyLevel = static_cast<int32_t>(mParty.getLevel());
+
+    // Resolve the levels once here instead of on every node of the search.
+    // Not every xp maps back onto a monster of that exact xp, so keep what the level actually rewards.
+    // Low level parties can't field monsters below level -1, which is the only way two party levels end up with different keys.
+    const auto validXps = getValidMonsterXPs(mMinimumMonsterXp.at(difficulty), mMaximumMonsterXp.at(difficulty));
+    std::vector<int32_t> monsterLevels(validXps.size());
+    std::vector<uint32_t> monsterXps(validXps.size());
+    GeneratorUtilities::getMonsterLevel(partyLevel, validXps.data(), monsterLevels.data(), validXps.size());
+    GeneratorUtilities::getMonsterXp(partyLevel, monsterLevels.data(), monsterXps.data(), validXps.size());
+
+    for (size_t i = 0; i < validXps.size(); ++i)
+    {
+        SearchEntry entry{};
+        entry.levelOffset = monsterLevels[i] - partyLevel;
+        entry.monsterXp = monsterXps[i];
+        entry.chunkSize = minXpPerLevel / validXps[i];
+        if (entry.chunkSize == 0) entry.chunkSize = 1;
+
+        key.entries.push_back(entry);
+    }
+
+    return key;
+}
+
+const std::vector<Encounter>& EncounterGenerator::getValidBattles(const Difficulty& difficulty) const
 {
-    mValidBattles.clear();
-    for(const auto& diff : DIFFICULTY_VECTOR)
+    auto& difficultyBattles = mValidBattles[static_cast<size_t>(difficulty)];
+    std::call_once(difficultyBattles.generated, [&]()
+    {
+        difficultyBattles.battles = fillOutEncounters(difficulty);
+    });
+
+    return difficultyBattles.battles;
+}
+
+std::vector<Encounter> EncounterGenerator::fillOutEncounters(const Difficulty& difficulty) const
+{
+    const auto templates = getTemplates(getSearchKey(difficulty), mNumThreads);
+
+    std::vector<Encounter> battles;
+    battles.reserve(templates->size());
+    for (const auto& encounterTemplate : *templates)
     {
-        std::vector<uint32_t> monsters;
-        auto validXps = getValidMonsterXPs(mMinimumMonsterXp[diff], mMaximumMonsterXp[diff]);
-        auto lowXp = mParty.getLowerDesiredXp(diff);
-        auto desiredXp = mParty.getDesiredXp(diff);
-        auto highXp = mParty.getUpperDesiredXp(diff);
-        fillOutHelper(monsters, diff, validXps, lowXp, desiredXp, highXp);
+        battles.push_back(encounterTemplate.toEncounter(mParty.getLevel()));
     }
 
+    return battles;
 }
 
-void EncounterGenerator::fillOutHelper(std::vector<uint32_t>& currentMonsters, const Difficulty& difficulty, const std::vector<uint32_t>& validXps, const uint32_t& lowXp, const uint32_t& desiredXp, const uint32_t& highXp)
+std::shared_ptr<const std::vector<EncounterTemplate>> EncounterGenerator::getTemplates(const SearchKey& key, const uint32_t& numThreads)
 {
-    // Get the current encounter as it stands.
-    const auto encounter = convertMonsterVectorToEncounter(currentMonsters);
-    const auto xp = encounter.getEncounterXp();
+    // Templates are kept for the life of the process. There are only a handful of keys per party size,
+    // as every party level from 6 up shares the same ones.
+    static std::mutex cacheMutex;
+    static std::map<SearchKey, std::shared_ptr<const std::vector<EncounterTemplate>>> templateCache;
 
-    // Run some checks to see if we should quit out now.
-    const auto tooManyTotalMonsters = currentMonsters.size() > mNumTotalMonsters;
-    const auto tooManyUniqueMonsters = encounter.getNumUniqueMonsters() > mNumUniqueMonsters;
-    const auto tooMuchXp = xp > highXp;
-    if (tooManyTotalMonsters || tooManyUniqueMonsters || tooMuchXp)
     {
-        return;
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        const auto cached = templateCache.find(key);
+        if (cached != templateCache.end())
+        {
+            return cached->second;
+        }
     }
 
-    // See if we are in a valid xp range.
-    const auto inXpRange = (xp >= lowXp) && (xp <= highXp);
+    // Search without holding the lock so parties with other keys aren't held up.
+    // Only spin up threads when asked to and the search has to be run, most parties are searched in a few milliseconds.
+    auto templates = std::make_shared<std::vector<EncounterTemplate>>();
+    if (numThreads != 1)
+    {
+        WorkStealingPool pool(numThreads);
+        *templates = searchInParallel(key, pool);
+    }
+    else
+    {
+        SearchState state{};
+        state.usedTotalMonsters.resize(key.numTotalMonsters + 1, false);
+        fillOutHelper(state, key, 0, *templates);
+    }
 
-    // When adding monsters into the map, add them in chunks that must make up at least 20% of allotted xp.
-    const auto minXpPerLevel = desiredXp / 5;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return templateCache.emplace(key, std::move(templates)).first->second;
+}
+
+std::shared_ptr<const EncounterSampler> EncounterGenerator::getSampler(const SearchKey& key)
+{
+    // Samplers are kept for the life of the process, just like the templates.
+    static std::mutex cacheMutex;
+    static std::map<SearchKey, std::shared_ptr<const EncounterSampler>> samplerCache;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        const auto cached = samplerCache.find(key);
+        if (cached != samplerCache.end())
+        {
+            return cached->second;
+        }
+    }
+
+    std::vector<std::pair<int32_t, uint32_t>> levelOffsetXps;
+    for (const auto& entry : key.entries)
+    {
+        levelOffsetXps.emplace_back(entry.levelOffset, entry.monsterXp);
+    }
+    auto sampler = std::make_shared<const EncounterSampler>(levelOffsetXps, key.lowXp, key.highXp, key.numUniqueMonsters, key.numTotalMonsters);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return samplerCache.emplace(key, std::move(sampler)).first->second;
+}
+
+template <typename Visit>
+void EncounterGenerator::forEachChild(SearchState& state, const SearchKey& key, const size_t& firstEntry, const Visit& visit)
+{
+    // Only ever add entries at or after the last one added, so every group of monsters is visited in exactly one order.
+    for (auto entryIndex = firstEntry; entryIndex < key.entries.size(); ++entryIndex)
+    {
+        const auto& entry = key.entries[entryIndex];
+        const auto isNewGroup = state.monsterGroups.empty() || state.monsterGroups.back().first != entry.levelOffset;
+        const auto numUniqueMonsters = state.monsterGroups.size() + (isNewGroup ? 1 : 0);
+
+        // Run some checks to see if adding these monsters would take us over any limit.
+        const auto tooManyTotalMonsters = state.numTotalMonsters + entry.chunkSize > key.numTotalMonsters;
+        const auto tooManyUniqueMonsters = numUniqueMonsters > key.numUniqueMonsters;
+        const auto tooMuchXp = state.xp + entry.monsterXp * entry.chunkSize > key.highXp;
+        if (tooManyTotalMonsters || tooManyUniqueMonsters || tooMuchXp)
+        {
+            continue;
+        }
+
+        // Add the monsters in. Recurse. Remove monsters.
+        if (isNewGroup)
+        {
+            state.monsterGroups.emplace_back(entry.levelOffset, 0);
+        }
+        state.monsterGroups.back().second += entry.chunkSize;
+        state.numTotalMonsters += entry.chunkSize;
+        state.xp += entry.monsterXp * entry.chunkSize;
+
+        visit(entryIndex);
+
+        state.xp -= entry.monsterXp * entry.chunkSize;
+        state.numTotalMonsters -= entry.chunkSize;
+        state.monsterGroups.back().second -= entry.chunkSize;
+        if (isNewGroup)
+        {
+            state.monsterGroups.pop_back();
+        }
+    }
+}
+
+void EncounterGenerator::fillOutHelper(SearchState& state, const SearchKey& key, const size_t& firstEntry, std::vector<EncounterTemplate>& templates)
+{
+    // See if we are in a valid xp range.
+    // The caller never recurses past the limits, so only the lower bound needs checking.
+    const auto inXpRange = state.xp >= key.lowXp;
 
     // If we are in the correct xp range do some last checks.
     // Ensure that only one battle per set has a unique number of monsters.
     // This stops it from having 3 entries in the table being nearly the same but just one level off with the same number of monsters.
-    if(inXpRange)
+    if(inXpRange && !state.usedTotalMonsters[state.numTotalMonsters])
     {
-        auto uniqueNumberOfMonsters = true;
-        const auto testNumMons = encounter.getNumTotalMonsters();
-
-        for(const auto& diffEncounter : mValidBattles[difficulty])
+        EncounterTemplate encounterTemplate;
+        for (const auto& monsterGroup : state.monsterGroups)
         {
-            const auto numSetMons = diffEncounter.getNumTotalMonsters();
-            uniqueNumberOfMonsters = uniqueNumberOfMonsters && (testNumMons != numSetMons);
+            encounterTemplate.addMonsters(monsterGroup.first, monsterGroup.second);
         }
 
-        if(uniqueNumberOfMonsters)
+        state.usedTotalMonsters[state.numTotalMonsters] = true;
+        templates.push_back(encounterTemplate);
+        return;
+    }
+
+    // We are not in a valid state yet, try to add more monsters in.
+    forEachChild(state, key, firstEntry, [&](const size_t& entryIndex)
+    {
+        fillOutHelper(state, key, entryIndex, templates);
+    });
+
+}
+
+std::vector<EncounterTemplate> EncounterGenerator::searchInParallel(const SearchKey& key, WorkStealingPool& pool)
+{
+    // Whether an encounter is accepted depends on everything the sequential search accepted before it.
+    // So every subtree records all of its in-range encounters, and acceptance is replayed afterwards in sequential order.
+    // A deque is used so segments don't move while tasks are filling them in.
+    std::deque<SearchRecords> segments;
+    std::vector<std::pair<size_t, size_t>> prefixSubtrees;
+    SearchState state{};
+    splitHelper(state, key, 0, 0, pool, segments, prefixSubtrees);
+    pool.wait();
+
+    // Stitch the segments together in the order the sequential search would have visited them.
+    SearchRecords allRecords;
+    std::vector<size_t> segmentStarts;
+    for (const auto& segment : segments)
+    {
+        segmentStarts.push_back(allRecords.records.size());
+        for (auto record : segment.records)
         {
-            mValidBattles[difficulty].push_back(encounter);
-            return;
+            record.firstGroup += allRecords.monsterGroups.size();
+            allRecords.records.push_back(record);
         }
+        allRecords.monsterGroups.insert(allRecords.monsterGroups.end(), segment.monsterGroups.begin(), segment.monsterGroups.end());
     }
+    segmentStarts.push_back(allRecords.records.size());
 
-    // We are not in a valid state yet, try to add more monsters in.
-    for(auto newXp : validXps)
+    // Records at the top of the tree have subtrees that were split over many segments.
+    for (const auto& prefixSubtree : prefixSubtrees)
     {
-        // Calculate how many monsters should be added in this batch
-        auto numNewMonsters = minXpPerLevel / newXp;
-        if (numNewMonsters == 0) numNewMonsters = 1;
+        const auto recordIndex = segmentStarts[prefixSubtree.first];
+        allRecords.records[recordIndex].numDescendants = segmentStarts[prefixSubtree.second] - recordIndex - 1;
+    }
 
-        // Add the monsters in. Recurse. Remove monsters.
-        for (uint32_t i = 0; i < numNewMonsters; i++)
+    // Accepting an encounter stops the sequential search from going any deeper, so skip everything below it.
+    std::vector<EncounterTemplate> templates;
+    std::vector<bool> usedTotalMonsters(key.numTotalMonsters + 1, false);
+    for (size_t recordIndex = 0; recordIndex < allRecords.records.size(); ++recordIndex)
+    {
+        const auto& record = allRecords.records[recordIndex];
+        if (usedTotalMonsters[record.numTotalMonsters])
         {
-            currentMonsters.push_back(newXp);
+            continue;
         }
-        fillOutHelper(currentMonsters, difficulty, validXps, lowXp, desiredXp, highXp);
-        for (uint32_t i = 0; i < numNewMonsters; i++)
+
+        EncounterTemplate encounterTemplate;
+        for (auto group = record.firstGroup; group < record.firstGroup + record.numGroups; ++group)
         {
-            currentMonsters.pop_back();
+            encounterTemplate.addMonsters(allRecords.monsterGroups[group].first, allRecords.monsterGroups[group].second);
         }
+
+        usedTotalMonsters[record.numTotalMonsters] = true;
+        templates.push_back(encounterTemplate);
+        recordIndex += record.numDescendants;
     }
 
+    return templates;
+}
+
+void EncounterGenerator::splitHelper(SearchState& state, const SearchKey& key, const size_t& firstEntry, const uint32_t& depth, WorkStealingPool& pool, std::deque<SearchRecords>& segments, std::vector<std::pair<size_t, size_t>>& prefixSubtrees)
+{
+    // Deep enough, hand the rest of this subtree out as a task.
+    if (depth == PARALLEL_SPLIT_DEPTH)
+    {
+        segments.emplace_back();
+        auto& records = segments.back();
+        pool.submit([state, &key, firstEntry, &records]() mutable
+        {
+            recordHelper(state, key, firstEntry, records);
+        });
+        return;
+    }
+
+    // Nodes above the split are recorded on their own, their subtree size is only known once every task is done.
+    const auto inXpRange = state.xp >= key.lowXp;
+    const auto prefixIndex = prefixSubtrees.size();
+    if (inXpRange)
+    {
+        segments.emplace_back();
+        addRecord(state, segments.back());
+        prefixSubtrees.emplace_back(segments.size() - 1, 0);
+    }
+
+    forEachChild(state, key, firstEntry, [&](const size_t& entryIndex)
+    {
+        splitHelper(state, key, entryIndex, depth + 1, pool, segments, prefixSubtrees);
+    });
+
+    if (inXpRange)
+    {
+        prefixSubtrees[prefixIndex].second = segments.size();
+    }
+}
+
+void EncounterGenerator::recordHelper(SearchState& state, const SearchKey& key, const size_t& firstEntry, SearchRecords& records)
+{
+    // Keep going below in-range encounters too, the replay decides whether they would have stopped the search.
+    const auto inXpRange = state.xp >= key.lowXp;
+    const auto recordIndex = records.records.size();
+    if (inXpRange)
+    {
+        addRecord(state, records);
+    }
+
+    forEachChild(state, key, firstEntry, [&](const size_t& entryIndex)
+    {
+        recordHelper(state, key, entryIndex, records);
+    });
+
+    if (inXpRange)
+    {
+        records.records[recordIndex].numDescendants = records.records.size() - recordIndex - 1;
+    }
+}
+
+void EncounterGenerator::addRecord(const SearchState& state, SearchRecords& records)
+{
+    SearchRecords::Record record{};
+    record.numTotalMonsters = state.numTotalMonsters;
+    record.firstGroup = records.monsterGroups.size();
+    record.numGroups = state.monsterGroups.size();
+
+    records.records.push_back(record);
+    records.monsterGroups.insert(records.monsterGroups.end(), state.monsterGroups.begin(), state.monsterGroups.end());
+}
+
+bool EncounterGenerator::SearchEntry::operator<(const SearchEntry& other) const
+{
+    return std::tie(levelOffset, monsterXp, chunkSize) < std::tie(other.levelOffset, other.monsterXp, other.chunkSize);
+}
+
+bool EncounterGenerator::SearchKey::operator<(const SearchKey& other) const
+{
+    return std::tie(lowXp, highXp, numUniqueMonsters, numTotalMonsters, entries) < std::tie(other.lowXp, other.highXp, other.numUniqueMonsters, other.numTotalMonsters, other.entries);
 }
@@ -0,0 +1,120 @@
+#include "EncounterSampler.h"
+
+#include <algorithm>
+
+using namespace Pathfinder;
+
+EncounterSampler::EncounterSampler(const std::vector<std::pair<int32_t, uint32_t>>& levelOffsetXps, const uint32_t& lowXp, const uint32_t& highXp, const uint32_t& numUniqueMonsters, const uint32_t& numTotalMonsters) :
+    mLowXp{ std::max(lowXp, 1u) },
+    mHighXp{ highXp }
+{
+    // Several xps can resolve to the same level offset, those are the same monsters.
+    for (const auto& levelOffsetXp : levelOffsetXps)
+    {
+        const auto sameOffset = [&](const std::pair<int32_t, uint32_t>& other) { return other.first == levelOffsetXp.first; };
+        if (levelOffsetXp.second != 0 && std::none_of(mLevelOffsetXps.begin(), mLevelOffsetXps.end(), sameOffset))
+        {
+            mLevelOffsetXps.push_back(levelOffsetXp);
+        }
+    }
+
+    // Limits past what the xp window can ever hold don't change the counts, only the table size.
+    uint32_t cheapestXp = mHighXp + 1;
+    for (const auto& levelOffsetXp : mLevelOffsetXps)
+    {
+        cheapestXp = std::min(cheapestXp, levelOffsetXp.second);
+    }
+    mNumUniqueMonsters = std::min(numUniqueMonsters, static_cast<uint32_t>(mLevelOffsetXps.size()));
+    mNumTotalMonsters = std::min(numTotalMonsters, mHighXp / cheapestXp);
+
+    const auto numItems = mLevelOffsetXps.size();
+    mNumWays.resize(getWaysIndex(numItems + 1, 0, 0, 0), 0);
+
+    // Having placed every level offset, a composition is valid only if its xp is in the window.
+    for (uint32_t numUnique = 0; numUnique <= mNumUniqueMonsters; ++numUnique)
+    {
+        for (uint32_t numTotal = 0; numTotal <= mNumTotalMonsters; ++numTotal)
+        {
+            for (auto xp = mLowXp; xp <= mHighXp; ++xp)
+            {
+                mNumWays[getWaysIndex(numItems, numUnique, numTotal, xp)] = 1;
+            }
+        }
+    }
+
+    // Otherwise either skip the level offset or field some of them, then move on to the next one.
+    for (auto item = numItems; item-- > 0;)
+    {
+        const auto monsterXp = mLevelOffsetXps[item].second;
+        for (uint32_t numUnique = 0; numUnique <= mNumUniqueMonsters; ++numUnique)
+        {
+            for (uint32_t numTotal = 0; numTotal <= mNumTotalMonsters; ++numTotal)
+            {
+                for (uint32_t xp = 0; xp <= mHighXp; ++xp)
+                {
+                    auto numWays = getNumWays(item + 1, numUnique, numTotal, xp);
+                    if (numUnique != 0)
+                    {
+                        for (uint32_t count = 1; count <= numTotal && xp + count * monsterXp <= mHighXp; ++count)
+                        {
+                            numWays += getNumWays(item + 1, numUnique - 1, numTotal - count, xp + count * monsterXp);
+                        }
+                    }
+                    mNumWays[getWaysIndex(item, numUnique, numTotal, xp)] = numWays;
+                }
+            }
+        }
+    }
+}
+
+uint64_t EncounterSampler::getNumCompositions() const
+{
+    return getNumWays(0, mNumUniqueMonsters, mNumTotalMonsters, 0);
+}
+
+EncounterTemplate EncounterSampler::getComposition(uint64_t index) const
+{
+    EncounterTemplate composition;
+
+    auto numUnique = mNumUniqueMonsters;
+    auto numTotal = mNumTotalMonsters;
+    uint32_t xp = 0;
+
+    // Walk the same choices the counts were built from, skipping over every choice whose compositions all come before the index.
+    for (size_t item = 0; item < mLevelOffsetXps.size(); ++item)
+    {
+        const auto skipWays = getNumWays(item + 1, numUnique, numTotal, xp);
+        if (index < skipWays)
+        {
+            continue;
+        }
+        index -= skipWays;
+
+        const auto monsterXp = mLevelOffsetXps[item].second;
+        for (uint32_t count = 1; count <= numTotal && xp + count * monsterXp <= mHighXp; ++count)
+        {
+            const auto countWays = getNumWays(item + 1, numUnique - 1, numTotal - count, xp + count * monsterXp);
+            if (index < countWays)
+            {
+                composition.addMonsters(mLevelOffsetXps[item].first, count);
+                numUnique -= 1;
+                numTotal -= count;
+                xp += count * monsterXp;
+                break;
+            }
+            index -= countWays;
+        }
+    }
+
+    return composition;
+}
+
+uint64_t EncounterSampler::getNumWays(size_t item, uint32_t numUnique, uint32_t numTotal, uint32_t xp) const
+{
+    return mNumWays[getWaysIndex(item, numUnique, numTotal, xp)];
+}
+
+size_t EncounterSampler::getWaysIndex(size_t item, uint32_t numUnique, uint32_t numTotal, uint32_t xp) const
+{
+    return ((item * (mNumUniqueMonsters + 1) + numUnique) * (mNumTotalMonsters + 1) + numTotal) * (mHighXp + 1) + xp;
+}
@@ -0,0 +1,41 @@
+#include "EncounterTemplate.h"
+
+#include <algorithm>
+
+using namespace Pathfinder;
+
+void EncounterTemplate::addMonsters(int32_t levelOffset, uint32_t numMonsters)
+{
+    mNumTotalMonsters += numMonsters;
+
+    auto group = std::lower_bound(mMonsterGroups.begin(), mMonsterGroups.end(), levelOffset,
+        [](const std::pair<int32_t, uint32_t>& monsterGroup, int32_t offset) { return monsterGroup.first < offset; });
+
+    if (group != mMonsterGroups.end() && group->first == levelOffset)
+    {
+        group->second += numMonsters;
+        return;
+    }
+
+    mMonsterGroups.emplace(group, levelOffset, numMonsters);
+}
+
+const std::vector<std::pair<int32_t, uint32_t>>& EncounterTemplate::getMonsterGroups() const
+{
+    return mMonsterGroups;
+}
+
+uint32_t EncounterTemplate::getNumTotalMonsters() const
+{
+    return mNumTotalMonsters;
+}
+
+Encounter EncounterTemplate::toEncounter(const int32_t& adventurerLevel) const
+{
+    Encounter encounter(adventurerLevel);
+    for (const auto& monsterGroup : mMonsterGroups)
+    {
+        encounter.addMonsters(adventurerLevel + monsterGroup.first, monsterGroup.second);
+    }
+    return encounter;
+}
@@ -0,0 +1,187 @@
+#include "EncounterWriter.h"
+
+#include <utility>
+
+const size_t EncounterWriter::DEFAULT_BLOCK_SIZE = 1 << 20;
+
+EncounterWriter::EncounterWriter(const std::string& filePath, bool writeInBackground, size_t blockSize) :
+    mFile(filePath, std::ios::binary | std::ios::trunc),
+    mBlockSize{ blockSize },
+    mIsOpen{ mFile.is_open() },
+    mHasFailed{ !mFile.is_open() },
+    mNumEncounters{ 0 },
+    mHasPendingBlock{ false },
+    mStopping{ false }
+{
+    if (!mIsOpen)
+    {
+        return;
+    }
+
+    mBuffer.reserve(mBlockSize);
+    if (writeInBackground)
+    {
+        mPendingBlock.reserve(mBlockSize);
+        mWriterThread = std::thread(&EncounterWriter::writerLoop, this);
+    }
+}
+
+EncounterWriter::~EncounterWriter()
+{
+    close();
+}
+
+void EncounterWriter::write(const StringView& text)
+{
+    if (!mIsOpen)
+    {
+        return;
+    }
+
+    mBuffer.append(text.data(), text.size());
+    if (mBuffer.size() >= mBlockSize)
+    {
+        submitBuffer();
+    }
+}
+
+void EncounterWriter::writeEncounter(const Difficulty& difficulty, const FilledEncounter& encounter)
+{
+    if (!mIsOpen)
+    {
+        return;
+    }
+
+    GeneratorUtilities::appendInteger(mBuffer, ++mNumEncounters);
+    mBuffer += ',';
+    mBuffer += GeneratorUtilities::toStringDifficulty(difficulty);
+    mBuffer += ',';
+    encounter.appendCsvString(mBuffer);
+    mBuffer += '\n';
+
+    if (mBuffer.size() >= mBlockSize)
+    {
+        submitBuffer();
+    }
+}
+
+bool EncounterWriter::flush()
+{
+    if (!mIsOpen)
+    {
+        return isGood();
+    }
+
+    submitBuffer();
+
+    if (mWriterThread.joinable())
+    {
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mStateChanged.wait(lock, [this] { return !mHasPendingBlock; });
+    }
+
+    // The background thread is idle now, so the file is safe to touch from here.
+    mFile.flush();
+    if (mFile.fail())
+    {
+        mHasFailed = true;
+    }
+    return isGood();
+}
+
+bool EncounterWriter::close()
+{
+    if (!mIsOpen)
+    {
+        return isGood();
+    }
+
+    flush();
+
+    if (mWriterThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mStateMutex);
+            mStopping = true;
+        }
+        mStateChanged.notify_all();
+        mWriterThread.join();
+    }
+
+    mFile.close();
+    if (mFile.fail())
+    {
+        mHasFailed = true;
+    }
+    mIsOpen = false;
+    return isGood();
+}
+
+bool EncounterWriter::isGood() const
+{
+    return !mHasFailed;
+}
+
+void EncounterWriter::submitBuffer()
+{
+    if (mBuffer.empty())
+    {
+        return;
+    }
+
+    if (!mWriterThread.joinable())
+    {
+        writeBlock(mBuffer);
+        mBuffer.clear();
+        return;
+    }
+
+    // Wait for the last block to be written, then swap buffers so the next block fills the one that was just written out.
+    {
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mStateChanged.wait(lock, [this] { return !mHasPendingBlock; });
+        std::swap(mBuffer, mPendingBlock);
+        mHasPendingBlock = true;
+    }
+    mStateChanged.notify_all();
+    mBuffer.clear();
+}
+
+void EncounterWriter::writeBlock(const std::string& block)
+{
+    // Once a write fails the file can't be trusted, so nothing more goes to it.
+    if (mHasFailed)
+    {
+        return;
+    }
+
+    mFile.write(block.data(), static_cast<std::streamsize>(block.size()));
+    if (mFile.fail())
+    {
+        mHasFailed = true;
+    }
+}
+
+void EncounterWriter::writerLoop()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mStateMutex);
+            mStateChanged.wait(lock, [this] { return mStopping || mHasPendingBlock; });
+            if (!mHasPendingBlock)
+            {
+                return;
+            }
+        }
+
+        writeBlock(mPendingBlock);
+
+        {
+            std::lock_guard<std::mutex> lock(mStateMutex);
+            mPendingBlock.clear();
+            mHasPendingBlock = false;
+        }
+        mStateChanged.notify_all();
+    }
+}
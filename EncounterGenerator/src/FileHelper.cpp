@@ -1,73 +1,518 @@
 #include "FileHelper.h"
+#include "CatalogReader.h"
+#include "CatalogWriter.h"
+#include "MappedFile.h"
+#include "StringView.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
-#include "Monster.h"
+#include "MonsterTable.h"
 
 using namespace Pathfinder;
 using namespace nlohmann;
 
-MonsterList FileHelper::parseJson(const std::string& jsonFilePath, bool parseUnique)
+namespace
 {
-    auto monsterList = MonsterList();
+    /**
+     * \brief Fields every monster in a monster list file has.
+     */
+    enum class MonsterField
+    {
+        Level = 0,
+        Rarity,
+        Name,
+        Traits,
+        Size,
+        Source,
+        None
+    };
 
-    std::ifstream ifs(jsonFilePath);
-    json parsedJson = json::parse(ifs);
+    const size_t NUM_MONSTER_FIELDS = static_cast<size_t>(MonsterField::None);
+
+    /**
+     * \brief Gets the field a json key or csv column is for.
+     * \param fieldName Name of the field.
+     * \return Field with that name, or None if it isn't one.
+     */
+    MonsterField toMonsterField(const StringView& fieldName)
+    {
+        const StringView FIELD_NAMES[] = { "Level", "Rarity", "Name", "Traits", "Size", "Source" };
+        const auto found = std::find(std::begin(FIELD_NAMES), std::end(FIELD_NAMES), fieldName);
+        return static_cast<MonsterField>(found - std::begin(FIELD_NAMES));
+    }
+
+    /**
+     * \brief Reads a level written as a whole number.
+     * \param levelString Text of the level.
+     * \param level Set to the level.
+     * \return If the text was a level.
+     */
+    bool parseLevel(const StringView& levelString, int32_t& level)
+    {
+        const auto isNegative = !levelString.empty() && levelString[0] == '-';
+        const size_t firstDigit = isNegative ? 1 : 0;
+        if (levelString.size() == firstDigit || levelString.size() > firstDigit + 9)
+        {
+            return false;
+        }
+
+        int32_t value = 0;
+        for (auto index = firstDigit; index < levelString.size(); ++index)
+        {
+            if (levelString[index] < '0' || levelString[index] > '9')
+            {
+                return false;
+            }
+            value = value * 10 + (levelString[index] - '0');
+        }
+
+        level = isNegative ? -value : value;
+        return true;
+    }
+
+    /**
+     * \brief Adds a monster read from a monster list file to a table, along with its Weak and Elite variants.
+     * \param monsterTable Table to add the monster to.
+     * \param level Level of the monster.
+     * \param fields Text of every field of the monster, indexed by MonsterField. The level is not read from here.
+     * \param parseUnique If unique monsters should be added.
+     * \param creatureTraits Reused to split the traits into.
+     */
+    void addMonsterRecord(MonsterTable& monsterTable, int32_t level, const std::array<StringView, NUM_MONSTER_FIELDS>& fields, bool parseUnique,
+        std::vector<StringView>& creatureTraits)
+    {
+        // Rarities and sizes are short enough to never leave the small string buffer.
+        const auto rarity = GeneratorUtilities::fromStringRarity(fields[static_cast<size_t>(MonsterField::Rarity)].toString());
+        const auto isUnique = rarity == Rarity::Unique;
+        if (isUnique && !parseUnique)
+        {
+            return;
+        }
+
+        GeneratorUtilities::fromStringCreatureTraits(fields[static_cast<size_t>(MonsterField::Traits)], creatureTraits);
+        const auto creatureSize = GeneratorUtilities::fromStringCreatureSize(fields[static_cast<size_t>(MonsterField::Size)].toString());
+
+        // Weak and Elite monsters aren't stored, they are variants of the record that get their level and name when asked for.
+        const auto monsterId = monsterTable.addMonster(fields[static_cast<size_t>(MonsterField::Name)], level, creatureSize, rarity, creatureTraits,
+            fields[static_cast<size_t>(MonsterField::Source)]);
+
+        if (!isUnique)
+        {
+            if (level != -1)
+            {
+                monsterTable.addVariant(monsterId, MonsterVariant::Weak);
+            }
+
+            monsterTable.addVariant(monsterId, MonsterVariant::Elite);
+        }
+    }
+
+    /**
+     * \brief Builds a monster table from the SAX events of a json monster list, one monster at a time.
+     *
+     * The list is an array of flat objects. Fields of the monster being read are kept in reused buffers and written to the table when its object ends,
+     * so no json tree is ever built.
+     */
+    class MonsterTableSax : public json_sax<json>
+    {
+    public:
+        MonsterTableSax(MonsterTable& monsterTable, bool parseUnique) :
+            mMonsterTable(monsterTable),
+            mParseUnique(parseUnique)
+        {
+        }
+
+        bool null() override
+        {
+            mField = MonsterField::None;
+            return true;
+        }
+
+        bool boolean(bool) override
+        {
+            mField = MonsterField::None;
+            return true;
+        }
+
+        bool number_integer(number_integer_t val) override
+        {
+            return setLevel(static_cast<int32_t>(val));
+        }
+
+        bool number_unsigned(number_unsigned_t val) override
+        {
+            return setLevel(static_cast<int32_t>(val));
+        }
+
+        bool number_float(number_float_t val, const string_t&) override
+        {
+            return setLevel(static_cast<int32_t>(val));
+        }
+
+        bool string(string_t& val) override
+        {
+            if (mField != MonsterField::None && mField != MonsterField::Level)
+            {
+                mFieldValues[static_cast<size_t>(mField)].assign(val);
+                mFoundFields |= fieldBit(mField);
+            }
+            return skipValue();
+        }
+
+        bool start_object(std::size_t) override
+        {
+            // Only objects directly inside the top level array are monsters, anything nested deeper is skipped.
+            ++mDepth;
+            if (mDepth == MONSTER_DEPTH)
+            {
+                mFoundFields = 0;
+            }
+            mField = MonsterField::None;
+            return true;
+        }
+
+        bool key(string_t& val) override
+        {
+            mField = mDepth == MONSTER_DEPTH ? toMonsterField(val) : MonsterField::None;
+            return true;
+        }
+
+        bool end_object() override
+        {
+            if (mDepth == MONSTER_DEPTH)
+            {
+                addMonster();
+            }
+            --mDepth;
+            mField = MonsterField::None;
+            return true;
+        }
+
+        bool start_array(std::size_t) override
+        {
+            ++mDepth;
+            mField = MonsterField::None;
+            return true;
+        }
+
+        bool end_array() override
+        {
+            --mDepth;
+            mField = MonsterField::None;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const detail::exception& ex) override
+        {
+            // Throw the same exceptions json::parse would, so callers see no difference.
+            if (ex.id / 100 == 4)
+            {
+                throw *static_cast<const detail::out_of_range*>(&ex);
+            }
+            throw *static_cast<const detail::parse_error*>(&ex);
+        }
+
+    private:
+        static const int32_t MONSTER_DEPTH = 2;
+        static const uint32_t ALL_FIELDS = (1u << NUM_MONSTER_FIELDS) - 1;
+
+        static uint32_t fieldBit(MonsterField field)
+        {
+            return 1u << static_cast<uint32_t>(field);
+        }
+
+        bool setLevel(int32_t level)
+        {
+            if (mField == MonsterField::Level)
+            {
+                mLevel = level;
+                mFoundFields |= fieldBit(MonsterField::Level);
+            }
+            return skipValue();
+        }
+
+        bool skipValue()
+        {
+            mField = MonsterField::None;
+            return true;
+        }
 
-    for(const auto& monsterObject : parsedJson)
+        void addMonster()
+        {
+            // A monster missing any of its fields can't be used, so it is left out.
+            if (mFoundFields != ALL_FIELDS)
+            {
+                return;
+            }
+
+            std::array<StringView, NUM_MONSTER_FIELDS> fields;
+            std::copy(mFieldValues.begin(), mFieldValues.end(), fields.begin());
+            addMonsterRecord(mMonsterTable, mLevel, fields, mParseUnique, mCreatureTraits);
+        }
+
+        MonsterTable& mMonsterTable;
+        bool mParseUnique;
+
+        int32_t mDepth{};
+        MonsterField mField{ MonsterField::None };
+        uint32_t mFoundFields{};
+
+        int32_t mLevel{};
+        std::array<std::string, NUM_MONSTER_FIELDS> mFieldValues;
+        std::vector<StringView> mCreatureTraits;
+    };
+
+    const int32_t MonsterTableSax::MONSTER_DEPTH;
+    const uint32_t MonsterTableSax::ALL_FIELDS;
+
+    /**
+     * \brief Splits csv text into records of fields, in place.
+     *
+     * Fields are views straight into the text. Only a quoted field with doubled quotes in it has to be copied, to take the extra quotes out.
+     * Quoted fields can hold commas and line breaks, and lines can end in either \n or \r\n.
+     */
+    class CsvReader
     {
-        auto parsedLevel = monsterObject["Level"].get<int32_t>();
-        auto parsedRarity = monsterObject["Rarity"].get<std::string>();
-        auto parsedName = monsterObject["Name"].get<std::string>();
-        auto parsedTraits = monsterObject["Traits"].get<std::string>();
-        auto parsedSize = monsterObject["Size"].get<std::string>();
-        auto parsedLocation = monsterObject["Source"].get<std::string>();
+    public:
+        CsvReader(const char* first, const char* last) :
+            mPosition{ first },
+            mEnd{ last }
+        {
+            // Spreadsheet exports like to start with a UTF-8 byte order mark.
+            if (mEnd - mPosition >= 3 && std::equal(mPosition, mPosition + 3, "\xEF\xBB\xBF"))
+            {
+                mPosition += 3;
+            }
+        }
 
-        Monster newMonster(
-            parsedName, 
-            parsedLevel,
-            GeneratorUtilities::fromStringCreatureSize(parsedSize), 
-            GeneratorUtilities::fromStringCreatureTraits(parsedTraits),
-            parsedLocation
-        );
+        /**
+         * \brief Read the next record.
+         * \param fields Filled with the fields of the record. They stay valid until the next record is read.
+         * \return If there was another record.
+         */
+        bool readRecord(std::vector<StringView>& fields)
+        {
+            fields.clear();
+            mNumUnescapedFields = 0;
+            if (mPosition == mEnd)
+            {
+                return false;
+            }
 
-        auto isUnique = parsedRarity == "Unique";
+            bool isEndOfRecord = false;
+            while (!isEndOfRecord)
+            {
+                fields.push_back(readField(isEndOfRecord));
+            }
+            return true;
+        }
 
-        if (!isUnique || (parseUnique && isUnique))
+    private:
+        /**
+         * \brief Read the next field and the comma or line break after it.
+         * \param isEndOfRecord Set to if the field was the last of its record.
+         * \return The field.
+         */
+        StringView readField(bool& isEndOfRecord)
         {
-            monsterList.addMonster(newMonster);
+            StringView field;
+            if (mPosition != mEnd && *mPosition == '"')
+            {
+                field = readQuotedField();
+            }
+            else
+            {
+                const auto* fieldStart = mPosition;
+                while (mPosition != mEnd && *mPosition != ',' && *mPosition != '\n' && *mPosition != '\r')
+                {
+                    ++mPosition;
+                }
+                field = StringView(fieldStart, static_cast<size_t>(mPosition - fieldStart));
+            }
+
+            // Anything stuck between a closing quote and the next delimiter is dropped.
+            while (mPosition != mEnd && *mPosition != ',' && *mPosition != '\n' && *mPosition != '\r')
+            {
+                ++mPosition;
+            }
+
+            isEndOfRecord = mPosition == mEnd || *mPosition != ',';
+            if (mPosition != mEnd && *mPosition == '\r')
+            {
+                ++mPosition;
+                if (mPosition != mEnd && *mPosition == '\n')
+                {
+                    ++mPosition;
+                }
+            }
+            else if (mPosition != mEnd)
+            {
+                ++mPosition;
+            }
+            return field;
+        }
 
-            if (!isUnique)
+        /**
+         * \brief Read a field that starts with a quote, up to its closing quote.
+         * \return The field without its quotes.
+         */
+        StringView readQuotedField()
+        {
+            ++mPosition;
+            const auto* fieldStart = mPosition;
+            std::string* unescaped = nullptr;
+            for (;;)
             {
-                if (parsedLevel != -1)
+                const auto* quote = std::find(mPosition, mEnd, '"');
+                if (quote == mEnd || quote + 1 == mEnd || quote[1] != '"')
                 {
-                    Monster weakNewMonster(
-                        "Weak " + parsedName,
-                        parsedLevel - 1,
-                        GeneratorUtilities::fromStringCreatureSize(parsedSize),
-                        GeneratorUtilities::fromStringCreatureTraits(parsedTraits),
-                        parsedLocation
-                    );
-
-                    monsterList.addMonster(weakNewMonster);
+                    // Closing quote, or the text ran out without one.
+                    if (unescaped == nullptr)
+                    {
+                        mPosition = quote == mEnd ? mEnd : quote + 1;
+                        return StringView(fieldStart, static_cast<size_t>(quote - fieldStart));
+                    }
+
+                    unescaped->append(mPosition, quote);
+                    mPosition = quote == mEnd ? mEnd : quote + 1;
+                    return StringView(*unescaped);
                 }
 
-                Monster eliteNewMonster(
-                    "Elite " + parsedName,
-                    parsedLevel + 1,
-                    GeneratorUtilities::fromStringCreatureSize(parsedSize),
-                    GeneratorUtilities::fromStringCreatureTraits(parsedTraits),
-                    parsedLocation
-                );
+                // A doubled quote is one quote in the field.
+                if (unescaped == nullptr)
+                {
+                    unescaped = &getUnescapedField();
+                    unescaped->assign(fieldStart, quote + 1);
+                }
+                else
+                {
+                    unescaped->append(mPosition, quote + 1);
+                }
+                mPosition = quote + 2;
+            }
+        }
+
+        /**
+         * \brief Get a buffer for a field that has to be copied, reusing the buffers of earlier records.
+         * \return Empty buffer that stays put until the next record is read.
+         */
+        std::string& getUnescapedField()
+        {
+            // A deque never moves its strings when it grows, so earlier fields of the record stay valid.
+            if (mNumUnescapedFields == mUnescapedFields.size())
+            {
+                mUnescapedFields.emplace_back();
+            }
+            auto& unescaped = mUnescapedFields[mNumUnescapedFields++];
+            unescaped.clear();
+            return unescaped;
+        }
+
+        const char* mPosition;
+        const char* mEnd;
 
-                monsterList.addMonster(eliteNewMonster);
+        std::deque<std::string> mUnescapedFields;
+        size_t mNumUnescapedFields{};
+    };
+}
+
+MonsterList FileHelper::parseJson(const std::string& jsonFilePath, bool parseUnique)
+{
+    auto monsterTable = std::make_shared<MonsterTable>();
+
+    std::ifstream ifs(jsonFilePath);
+    MonsterTableSax sax(*monsterTable, parseUnique);
+    json::sax_parse(ifs, &sax);
+
+    return MonsterList(monsterTable);
+}
+
+MonsterList FileHelper::parseCsv(const std::string& csvFilePath, bool parseUnique)
+{
+    auto monsterTable = std::make_shared<MonsterTable>();
+
+    const MappedFile csvFile(csvFilePath);
+    if (!csvFile.isOpen())
+    {
+        return MonsterList(monsterTable);
+    }
+
+    CsvReader reader(csvFile.data(), csvFile.data() + csvFile.size());
+    std::vector<StringView> fields;
+
+    // The header says which column holds which field, so the columns can come in any order.
+    std::array<size_t, NUM_MONSTER_FIELDS> fieldColumns;
+    fieldColumns.fill(SIZE_MAX);
+    if (reader.readRecord(fields))
+    {
+        for (size_t column = 0; column < fields.size(); ++column)
+        {
+            const auto field = toMonsterField(fields[column]);
+            if (field != MonsterField::None)
+            {
+                fieldColumns[static_cast<size_t>(field)] = column;
             }
         }
     }
 
-    return monsterList;
+    // Without every field no monster can be read.
+    const auto lastColumn = *std::max_element(fieldColumns.begin(), fieldColumns.end());
+    if (lastColumn == SIZE_MAX)
+    {
+        return MonsterList(monsterTable);
+    }
+
+    std::array<StringView, NUM_MONSTER_FIELDS> monsterFields;
+    std::vector<StringView> creatureTraits;
+    while (reader.readRecord(fields))
+    {
+        // Short rows, like blank lines, and rows without a level are left out.
+        int32_t level = 0;
+        if (fields.size() <= lastColumn || !parseLevel(fields[fieldColumns[static_cast<size_t>(MonsterField::Level)]], level))
+        {
+            continue;
+        }
+
+        for (size_t field = 0; field < NUM_MONSTER_FIELDS; ++field)
+        {
+            monsterFields[field] = fields[fieldColumns[field]];
+        }
+        addMonsterRecord(*monsterTable, level, monsterFields, parseUnique, creatureTraits);
+    }
+
+    return MonsterList(monsterTable);
+}
+
+MonsterList FileHelper::loadCatalog(const std::string& catalogPath)
+{
+    CatalogReader reader(catalogPath);
+    auto monsterTable = std::make_shared<MonsterTable>();
+    auto monsterIndex = std::make_shared<MonsterIndex>();
+    if (!monsterTable->readCatalog(reader) || !monsterIndex->readCatalog(reader) || !reader.isAtEnd() ||
+        monsterIndex->size() != monsterTable->size() || monsterIndex->getNumTraits() != monsterTable->getTraitDictionary().size())
+    {
+        return MonsterList();
+    }
+
+    return MonsterList(monsterTable, monsterIndex);
+}
+
+bool FileHelper::writeCatalog(const MonsterList& monsterList, const std::string& catalogPath)
+{
+    const auto monsterTable = monsterList.getMonsterTable();
+
+    CatalogWriter writer;
+    monsterTable->writeCatalog(writer);
+    MonsterIndex(*monsterTable).writeCatalog(writer);
+    return writer.writeToFile(catalogPath);
 }
 
 void FileHelper::writeToFile(const std::string& filePath, const std::string& fileContent)
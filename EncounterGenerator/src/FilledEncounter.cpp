@@ -1,93 +1,280 @@
 #include "FilledEncounter.h"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 
 using namespace Pathfinder;
 
+constexpr uint32_t FilledEncounter::MAX_MONSTER_GROUPS;
+
 FilledEncounter::FilledEncounter(const int32_t& adventurerLevel) :
-    mAdventurerLevel{adventurerLevel}
+    FilledEncounter(adventurerLevel, nullptr)
 {
 }
 
-void FilledEncounter::addMonsters(const Monster& monster, uint32_t numMonsters)
+FilledEncounter::FilledEncounter(const int32_t& adventurerLevel, const std::shared_ptr<const MonsterTable>& monsterTable) :
+    mMonsterTable{monsterTable},
+    mAdventurerLevel{adventurerLevel},
+    mEncounterXp{0},
+    mNumTotalMonsters{0},
+    mNumUniqueMonsters{0},
+    mMonsterCounts{}
 {
-    mMonsterMap[monster] += numMonsters;
 }
 
-void FilledEncounter::removeMonsters(const Monster& monster, uint32_t numMonsters)
+bool FilledEncounter::operator==(const FilledEncounter& other) const
+{
+    return mAdventurerLevel == other.mAdventurerLevel
+        && mNumUniqueMonsters == other.mNumUniqueMonsters
+        && (mNumUniqueMonsters == 0 || mMonsterTable == other.mMonsterTable)
+        && std::equal(begin(), end(), other.begin(), [](const MonsterCount& monsterCount, const MonsterCount& otherCount)
+        {
+            return monsterCount.monsterId == otherCount.monsterId && monsterCount.count == otherCount.count;
+        });
+}
+
+bool FilledEncounter::operator!=(const FilledEncounter& other) const
 {
-    if(mMonsterMap.count(monster) != 0)
+    return !(*this == other);
+}
+
+bool FilledEncounter::addMonsters(const Monster& monster, uint32_t numMonsters)
+{
+    const auto& monsterTable = monster.getMonsterTable();
+    if (!mMonsterTable)
+    {
+        mMonsterTable = monsterTable;
+    }
+    else if (mMonsterTable != monsterTable)
     {
-        if (mMonsterMap[monster] <= numMonsters)
+        // Monsters made one at a time each have a table of their own. One already in the encounter just gets counted again.
+        auto group = findGroup(*monsterTable, monster.getMonsterId());
+        if (group != mMonsterCounts.data() + mNumUniqueMonsters && compareMonsters(group->monsterId, *monsterTable, monster.getMonsterId()) == 0)
         {
-            mMonsterMap.erase(monster);
+            return addMonsters(group->monsterId, numMonsters);
         }
-        else
+
+        if (mNumUniqueMonsters == MAX_MONSTER_GROUPS)
+        {
+            return false;
+        }
+
+        // Otherwise every monster moves into a new table along with this one, so tables that are shared are never changed.
+        auto ownTable = std::make_shared<MonsterTable>();
+        for (auto monsterCount = mMonsterCounts.data(); monsterCount != mMonsterCounts.data() + mNumUniqueMonsters; ++monsterCount)
+        {
+            monsterCount->monsterId = ownTable->addMonster(*mMonsterTable, monsterCount->monsterId);
+        }
+        const auto monsterId = ownTable->addMonster(*monsterTable, monster.getMonsterId());
+        mMonsterTable = std::move(ownTable);
+        return addMonsters(monsterId, numMonsters);
+    }
+
+    return addMonsters(monster.getMonsterId(), numMonsters);
+}
+
+bool FilledEncounter::addMonsters(MonsterId monsterId, uint32_t numMonsters)
+{
+    if (!mMonsterTable)
+    {
+        return false;
+    }
+
+    auto group = findGroup(*mMonsterTable, monsterId);
+    if (group == mMonsterCounts.data() + mNumUniqueMonsters || compareMonsters(group->monsterId, *mMonsterTable, monsterId) != 0)
+    {
+        if (mNumUniqueMonsters == MAX_MONSTER_GROUPS)
         {
-            mMonsterMap[monster] -= numMonsters;
+            return false;
         }
+
+        // Shift the later monsters up one to keep the groups sorted.
+        std::move_backward(group, mMonsterCounts.data() + mNumUniqueMonsters, mMonsterCounts.data() + mNumUniqueMonsters + 1);
+        group->monsterId = monsterId;
+        group->count = 0;
+        ++mNumUniqueMonsters;
+    }
+
+    // Counts are stored in 16 bits, the same as Encounter.
+    const auto numAdded = std::min<uint32_t>(numMonsters, std::numeric_limits<uint16_t>::max() - group->count);
+    group->count = static_cast<uint16_t>(group->count + numAdded);
+    mNumTotalMonsters += numAdded;
+    mEncounterXp += GeneratorUtilities::getMonsterXp(mAdventurerLevel, mMonsterTable->getLevel(group->monsterId)) * numAdded;
+    return numAdded == numMonsters;
+}
+
+void FilledEncounter::removeMonsters(const Monster& monster, uint32_t numMonsters)
+{
+    if (mNumUniqueMonsters == 0)
+    {
+        return;
+    }
+
+    // The monster can be from another table than the encounter, if it was copied in when it was added.
+    const auto& monsterTable = *monster.getMonsterTable();
+    auto group = findGroup(monsterTable, monster.getMonsterId());
+    if (group == mMonsterCounts.data() + mNumUniqueMonsters || compareMonsters(group->monsterId, monsterTable, monster.getMonsterId()) != 0)
+    {
+        return;
+    }
+
+    const auto numRemoved = std::min<uint32_t>(numMonsters, group->count);
+    mNumTotalMonsters -= numRemoved;
+    mEncounterXp -= GeneratorUtilities::getMonsterXp(mAdventurerLevel, mMonsterTable->getLevel(group->monsterId)) * numRemoved;
+
+    if (group->count <= numMonsters)
+    {
+        std::move(group + 1, mMonsterCounts.data() + mNumUniqueMonsters, group);
+        --mNumUniqueMonsters;
+        mMonsterCounts[mNumUniqueMonsters] = MonsterCount{};
+    }
+    else
+    {
+        group->count = static_cast<uint16_t>(group->count - numRemoved);
     }
 }
 
 std::map<Monster, uint32_t> FilledEncounter::getMonsterMap() const
 {
-    return mMonsterMap;
+    std::map<Monster, uint32_t> monsterMap;
+    for (const auto& monsterCount : *this)
+    {
+        monsterMap[Monster(mMonsterTable, monsterCount.monsterId)] = monsterCount.count;
+    }
+    return monsterMap;
+}
+
+const FilledEncounter::MonsterCount* FilledEncounter::begin() const
+{
+    return mMonsterCounts.data();
+}
+
+const FilledEncounter::MonsterCount* FilledEncounter::end() const
+{
+    return mMonsterCounts.data() + mNumUniqueMonsters;
+}
+
+const std::shared_ptr<const MonsterTable>& FilledEncounter::getMonsterTable() const
+{
+    return mMonsterTable;
+}
+
+int32_t FilledEncounter::getEncounterLevel() const
+{
+    return mAdventurerLevel;
 }
 
 uint32_t FilledEncounter::getNumUniqueMonsters() const
 {
-    return static_cast<uint32_t>(mMonsterMap.size());
+    return mNumUniqueMonsters;
 }
 
 uint32_t FilledEncounter::getNumTotalMonsters() const
 {
-    auto numMonsters = 0;
-    for (const auto& crNumPair : mMonsterMap)
-    {
-        numMonsters += crNumPair.second;
-    }
-    return numMonsters;
+    return mNumTotalMonsters;
 }
 
 uint32_t FilledEncounter::getEncounterXp() const
 {
-    auto battleXp = 0;
-    for (const auto &monsterGroup : mMonsterMap)
+    return mEncounterXp;
+}
+
+size_t FilledEncounter::hash() const
+{
+    // FNV-1a over the adventurer level and every monster count.
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+
+    mix(static_cast<uint32_t>(mAdventurerLevel));
+    for (const auto& monsterCount : *this)
     {
-        battleXp += GeneratorUtilities::getMonsterXp(mAdventurerLevel, monsterGroup.first.getLevel()) * monsterGroup.second;
+        mix((static_cast<uint64_t>(monsterCount.monsterId) << 16) | monsterCount.count);
     }
-    return battleXp;
+    return static_cast<size_t>(hash);
 }
 
-std::string FilledEncounter::toString() const
+int FilledEncounter::compareMonsters(MonsterId monsterId, const MonsterTable& otherTable, MonsterId otherId) const
 {
-    std::string FilledEncounterString = "";
-    for (auto monsterPair : mMonsterMap)
+    const auto level = mMonsterTable->getLevel(monsterId);
+    const auto otherLevel = otherTable.getLevel(otherId);
+    if (level != otherLevel)
     {
-        FilledEncounterString += std::to_string(monsterPair.second) + " " + monsterPair.first.getName() + "(" + monsterPair.first.getLocation() + ")" + " : ";
+        return level < otherLevel ? -1 : 1;
     }
-    // Get rid of the fence post stuff.
-    FilledEncounterString.pop_back();
-    FilledEncounterString.pop_back();
-    FilledEncounterString.pop_back();
 
+    return mMonsterTable->compareNames(monsterId, otherTable, otherId);
+}
+
+FilledEncounter::MonsterCount* FilledEncounter::findGroup(const MonsterTable& monsterTable, MonsterId monsterId)
+{
+    return std::lower_bound(mMonsterCounts.data(), mMonsterCounts.data() + mNumUniqueMonsters, monsterId,
+        [this, &monsterTable](const MonsterCount& monsterCount, MonsterId groupId) { return compareMonsters(monsterCount.monsterId, monsterTable, groupId) < 0; });
+}
+
+std::string FilledEncounter::toString() const
+{
+    std::string FilledEncounterString;
+    appendString(FilledEncounterString);
     return FilledEncounterString;
 }
 
-std::string FilledEncounter::toCsvString() const
+void FilledEncounter::appendString(std::string& buffer) const
 {
-    std::string FilledEncounterString = "";
-    for (auto monsterPair : mMonsterMap)
+    // Everything is written straight out of the monster table, so nothing but the buffer gets allocated.
+    auto isFirst = true;
+    for (const auto& monsterCount : *this)
     {
-        FilledEncounterString += std::to_string(monsterPair.second) + ","
-                            + std::to_string(monsterPair.first.getLevel()) + ","
-                            + monsterPair.first.getName() + ","
-                            + GeneratorUtilities::toStringCreatureTraits(monsterPair.first.getCreatureTraits()) + ","
-                            + monsterPair.first.getLocation() + ",";
+        if (!isFirst)
+        {
+            buffer += " : ";
+        }
+        isFirst = false;
+
+        const auto& monsterTable = *mMonsterTable;
+        const auto monsterId = monsterCount.monsterId;
+        GeneratorUtilities::appendInteger(buffer, monsterCount.count);
+        buffer += ' ';
+        monsterTable.appendName(monsterId, buffer);
+        buffer += '(';
+        monsterTable.appendLocation(monsterId, buffer);
+        buffer += ')';
     }
-    // Get rid of the fence post stuff.
-    FilledEncounterString.pop_back();
+}
 
+std::string FilledEncounter::toCsvString() const
+{
+    std::string FilledEncounterString;
+    appendCsvString(FilledEncounterString);
     return FilledEncounterString;
 }
 
+void FilledEncounter::appendCsvString(std::string& buffer) const
+{
+    auto isFirst = true;
+    for (const auto& monsterCount : *this)
+    {
+        if (!isFirst)
+        {
+            buffer += ',';
+        }
+        isFirst = false;
+
+        const auto& monsterTable = *mMonsterTable;
+        const auto monsterId = monsterCount.monsterId;
+        GeneratorUtilities::appendInteger(buffer, monsterCount.count);
+        buffer += ',';
+        GeneratorUtilities::appendInteger(buffer, monsterTable.getLevel(monsterId));
+        buffer += ',';
+        monsterTable.appendName(monsterId, buffer);
+        buffer += ',';
+        monsterTable.appendCreatureTraits(monsterId, buffer);
+        buffer += ',';
+        monsterTable.appendLocation(monsterId, buffer);
+    }
+}
+
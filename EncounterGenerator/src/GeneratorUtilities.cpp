@@ -1,62 +1,32 @@
 #include "GeneratorUtilities.h"
 
-#include <iterator>
 #include <map>
-#include <sstream>
+#include <unordered_map>
 
 namespace Pathfinder
 {
 
-    uint32_t GeneratorUtilities::getMonsterXp(const int32_t& adventurerLevel, const int32_t& monsterLevel)
-    {
-        if(monsterLevel < -1)
-        {
-            return 0;
-        }
+    constexpr int8_t XpToLevelDeltaTable::NO_LEVEL_DELTA;
+    constexpr uint32_t XpToLevelDeltaTable::MAX_XP;
 
-        auto levelDifference = monsterLevel - adventurerLevel;
+    static_assert(GeneratorUtilities::getMonsterLevel(10, 160) == 16, "The most xp maps onto a +6 monster.");
+    static_assert(GeneratorUtilities::getMonsterLevel(10, 100) == 14, "Xp between table entries floors.");
+    static_assert(GeneratorUtilities::getMonsterLevel(1, 21) == -1, "Monsters can't go below the lowest level.");
 
-        switch (levelDifference)
+    void GeneratorUtilities::getMonsterXp(const int32_t& adventurerLevel, const int32_t* monsterLevels, uint32_t* monsterXps, size_t numMonsters)
+    {
+        for (size_t i = 0; i < numMonsters; ++i)
         {
-            case -7: return MONSTER_XP_TABLE[0];
-            case -6: return MONSTER_XP_TABLE[1];
-            case -5: return MONSTER_XP_TABLE[2];
-            case -4: return MONSTER_XP_TABLE[3];
-            case -3: return MONSTER_XP_TABLE[4];
-            case -2: return MONSTER_XP_TABLE[5];
-            case -1: return MONSTER_XP_TABLE[6];
-            case 0: return MONSTER_XP_TABLE[7];
-            case 1: return MONSTER_XP_TABLE[8];
-            case 2: return MONSTER_XP_TABLE[9];
-            case 3: return MONSTER_XP_TABLE[10];
-            case 4: return MONSTER_XP_TABLE[11];
-            case 5: return MONSTER_XP_TABLE[12];
-            case 6: return MONSTER_XP_TABLE[13];
-            case 7: return MONSTER_XP_TABLE[14];
-            default: return 0;
+            monsterXps[i] = getMonsterXp(adventurerLevel, monsterLevels[i]);
         }
-
     }
 
-    int32_t GeneratorUtilities::getMonsterLevel(const int32_t& adventurerLevel, const uint32_t& xp)
+    void GeneratorUtilities::getMonsterLevel(const int32_t& adventurerLevel, const uint32_t* monsterXps, int32_t* monsterLevels, size_t numMonsters)
     {
-        const auto xpToLevelMap = generateXpToLevelMap(adventurerLevel);
-        if (xpToLevelMap.count(xp))
-        {
-            return xpToLevelMap.at(xp);
-        }
-
-        // No exact match was found. Find the closest while flooring.
-        for(auto iter = MONSTER_XP_TABLE.rbegin(); iter != MONSTER_XP_TABLE.rend(); ++iter)
+        for (size_t i = 0; i < numMonsters; ++i)
         {
-            const auto monsterXp = *iter;
-            if(monsterXp < xp)
-            {
-                return getMonsterLevel(adventurerLevel, monsterXp);
-            }
+            monsterLevels[i] = getMonsterLevel(adventurerLevel, monsterXps[i]);
         }
-
-        return -1;
     }
 
     std::string GeneratorUtilities::toStringDifficulty(const Difficulty& difficulty)
@@ -119,60 +89,164 @@ namespace Pathfinder
         }
         if (creatureSizeString == "Small")
         {
-            return CreatureSize::Tiny;
+            return CreatureSize::Small;
         }
         if (creatureSizeString == "Medium")
         {
-            return CreatureSize::Tiny;
+            return CreatureSize::Medium;
         }
         if (creatureSizeString == "Large")
         {
-            return CreatureSize::Tiny;
+            return CreatureSize::Large;
         }
         if (creatureSizeString == "Huge")
         {
-            return CreatureSize::Tiny;
+            return CreatureSize::Huge;
         }
         if (creatureSizeString == "Gargantuan")
         {
-            return CreatureSize::Tiny;
+            return CreatureSize::Gargantuan;
         }
         return CreatureSize::INVALID;
     }
 
+    std::string GeneratorUtilities::toStringRarity(const Rarity& rarity)
+    {
+        switch (rarity)
+        {
+        case Rarity::Common: return "Common";
+        case Rarity::Uncommon: return "Uncommon";
+        case Rarity::Rare: return "Rare";
+        case Rarity::Unique: return "Unique";
+        default: return "Invalid Rarity";
+        }
+    }
+
+    Rarity GeneratorUtilities::fromStringRarity(const std::string& rarityString)
+    {
+        if (rarityString == "Common")
+        {
+            return Rarity::Common;
+        }
+        if (rarityString == "Uncommon")
+        {
+            return Rarity::Uncommon;
+        }
+        if (rarityString == "Rare")
+        {
+            return Rarity::Rare;
+        }
+        if (rarityString == "Unique")
+        {
+            return Rarity::Unique;
+        }
+        return Rarity::INVALID;
+    }
+
     std::string GeneratorUtilities::toStringCreatureTraits(const std::vector<std::string>& creatureTraits)
     {
-        std::stringstream  s;
-        std::copy(creatureTraits.begin(), creatureTraits.end(), std::ostream_iterator<std::string>(s, ";"));
-        return s.str();
+        std::string creatureTraitsString;
+        for (const auto& creatureTrait : creatureTraits)
+        {
+            creatureTraitsString += creatureTrait;
+            creatureTraitsString += ';';
+        }
+        return creatureTraitsString;
     }
 
-    std::vector<std::string> GeneratorUtilities::fromStringCreatureTraits(const std::string& creatureTraitsString)
+    void GeneratorUtilities::appendInteger(std::string& buffer, const int64_t& value)
     {
-        std::vector<std::string> tokens;
-        std::string trait;
-        std::istringstream traitStream(creatureTraitsString);
+        // Digits come out lowest first, so fill a small buffer from the back. 20 digits fit any 64 bit number.
+        char digits[20];
+        auto digitsStart = sizeof(digits);
+        auto magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        do
+        {
+            digits[--digitsStart] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
 
-        while (std::getline(traitStream, trait, ';')) {
-            tokens.push_back(trait);
+        if (value < 0)
+        {
+            buffer += '-';
         }
+        buffer.append(digits + digitsStart, sizeof(digits) - digitsStart);
+    }
 
+    uint32_t GeneratorUtilities::getLowestSetBit(const uint64_t& word)
+    {
+        // A de Bruijn multiply, which works the same on every compiler.
+        static const uint32_t DE_BRUIJN_POSITIONS[64] = {
+            0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+        };
+        return DE_BRUIJN_POSITIONS[((word & (~word + 1)) * 0x03f79d71b4cb0a89ULL) >> 58];
+    }
+
+    std::vector<std::string> GeneratorUtilities::fromStringCreatureTraits(const std::string& creatureTraitsString)
+    {
+        std::vector<StringView> traitViews;
+        fromStringCreatureTraits(creatureTraitsString, traitViews);
+
+        std::vector<std::string> tokens;
+        tokens.reserve(traitViews.size());
+        for (const auto& traitView : traitViews)
+        {
+            tokens.push_back(traitView.toString());
+        }
         return tokens;
     }
 
-    std::map<uint32_t, int32_t> GeneratorUtilities::generateXpToLevelMap(const int32_t& adventurerLevel)
+    void GeneratorUtilities::fromStringCreatureTraits(const StringView& creatureTraitsString, std::vector<StringView>& creatureTraits)
     {
-        std::map<uint32_t, int32_t> xpToLevelMap;
+        // Splits like std::getline would, so a trailing semicolon doesn't make an empty trait.
+        creatureTraits.clear();
+        const auto* traitStart = creatureTraitsString.begin();
+        while (traitStart != creatureTraitsString.end())
+        {
+            const auto* traitEnd = std::find(traitStart, creatureTraitsString.end(), ';');
+            creatureTraits.emplace_back(traitStart, static_cast<size_t>(traitEnd - traitStart));
+            traitStart = traitEnd == creatureTraitsString.end() ? traitEnd : traitEnd + 1;
+        }
+    }
 
-        for(auto levelMod = -7; levelMod < 7; ++levelMod)
+    std::vector<size_t> GeneratorUtilities::sampleIndices(size_t populationSize, size_t numSamples, RandomEngine& engine)
+    {
+        if (populationSize == 0 || numSamples == 0)
         {
-            auto monsterLevel = adventurerLevel + levelMod;
-            auto monsterXp = getMonsterXp(adventurerLevel, monsterLevel);
-            if(monsterXp != 0)
-            {
-                xpToLevelMap[monsterXp] = monsterLevel;
-            }
+            return {};
         }
-        return xpToLevelMap;
+
+        const auto numDistinct = std::min(numSamples, populationSize);
+        std::vector<size_t> samples;
+        samples.reserve(numSamples);
+
+        // Positions that have been swapped away from holding their own index. Everything else still holds itself.
+        std::unordered_map<size_t, size_t> swappedPositions;
+        swappedPositions.reserve(numDistinct * 2);
+        const auto valueAt = [&](size_t position)
+        {
+            const auto swapped = swappedPositions.find(position);
+            return swapped != swappedPositions.end() ? swapped->second : position;
+        };
+
+        for (size_t i = 0; i < numDistinct; ++i)
+        {
+            // nextBelow rather than a standard distribution, whose results differ between standard libraries.
+            const auto position = i + static_cast<size_t>(engine.nextBelow(populationSize - i));
+            const auto picked = valueAt(position);
+            swappedPositions[position] = valueAt(i);
+            samples.push_back(picked);
+        }
+
+        // if we loop over, just keep repeating the same order so that we always get how many we ask for.
+        for (auto i = numDistinct; i < numSamples; ++i)
+        {
+            samples.push_back(samples[i % numDistinct]);
+        }
+
+        return samples;
     }
 }
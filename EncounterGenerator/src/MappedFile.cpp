@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+    const auto file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        // The mapping keeps the file open on its own, so the file handle can go right away.
+        const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            const auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr)
+            {
+                mData = static_cast<const char*>(view);
+                mSize = static_cast<size_t>(fileSize.QuadPart);
+                mMappingHandle = mapping;
+            }
+            else
+            {
+                CloseHandle(mapping);
+            }
+        }
+    }
+
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != nullptr)
+    {
+        UnmapViewOfFile(mData);
+        CloseHandle(mMappingHandle);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+    const auto file = open(filePath.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        return;
+    }
+
+    struct stat fileStatus;
+    if (fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0)
+    {
+        // A shared mapping of the file lets every process that maps it use the same pages of the page cache.
+        const auto fileSize = static_cast<size_t>(fileStatus.st_size);
+        const auto view = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, file, 0);
+        if (view != MAP_FAILED)
+        {
+            mData = static_cast<const char*>(view);
+            mSize = fileSize;
+        }
+    }
+
+    close(file);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != nullptr)
+    {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+    return mData != nullptr;
+}
+
+const char* MappedFile::data() const
+{
+    return mData;
+}
+
+size_t MappedFile::size() const
+{
+    return mSize;
+}
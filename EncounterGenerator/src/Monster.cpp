@@ -1,69 +1,73 @@
 #include "Monster.h"
 
-Monster::Monster(const std::string& name, const int32_t& level, const CreatureSize& creatureSize, const std::vector<std::string>& creatureTraits, const std::string& location) :
-    mName{ name },
-    mLevel{ level },
-    mCreatureSize{ creatureSize },
-    mCreatureTraits{ creatureTraits },
-    mLocation{ location }
+namespace
 {
+    /**
+     * \brief Builds a table holding just the one given monster.
+     */
+    std::shared_ptr<const MonsterTable> makeSingleMonsterTable(const std::string& name, const int32_t& level, const CreatureSize& creatureSize,
+        const std::vector<std::string>& creatureTraits, const std::string& location, const Rarity& rarity)
+    {
+        auto monsterTable = std::make_shared<MonsterTable>();
+        monsterTable->addMonster(name, level, creatureSize, rarity, creatureTraits, location);
+        return monsterTable;
+    }
 }
 
-bool Monster::operator==(const Monster& other) const
+Monster::Monster(const std::string& name, const int32_t& level, const CreatureSize& creatureSize, const std::vector<std::string>& creatureTraits, const std::string& location,
+    const Rarity& rarity) :
+    mMonsterTable{ makeSingleMonsterTable(name, level, creatureSize, creatureTraits, location, rarity) },
+    mMonsterId{ 0 }
 {
+}
 
-    if(mName != other.mName)
-    {
-        return false;
-    }
-    if (mLevel != other.mLevel)
-    {
-        return false;
-    }
-    if (mCreatureSize != other.mCreatureSize)
-    {
-        return false;
-    }
-    if (mCreatureTraits != other.mCreatureTraits)
-    {
-        return false;
-    }
-    if (mLocation != other.mLocation)
+Monster::Monster(const std::shared_ptr<const MonsterTable>& monsterTable, const MonsterId& monsterId) :
+    mMonsterTable{ monsterTable },
+    mMonsterId{ monsterId }
+{
+}
+
+bool Monster::operator==(const Monster& other) const
+{
+    if (mMonsterTable == other.mMonsterTable && mMonsterId == other.mMonsterId)
     {
-        return false;
+        return true;
     }
-    return true;
+    return mMonsterTable->isSameMonster(mMonsterId, *other.mMonsterTable, other.mMonsterId);
 }
 
 bool Monster::operator<(const Monster& other) const
 {
-    if(mLevel != other.mLevel)
+    const auto level = getLevel();
+    const auto otherLevel = other.getLevel();
+    if(level != otherLevel)
     {
-        return mLevel < other.mLevel;
+        return level < otherLevel;
     }
 
-    return mName < other.mName;
+    return mMonsterTable->compareNames(mMonsterId, *other.mMonsterTable, other.mMonsterId) < 0;
 }
 
 bool Monster::isValid() const
 {
-    if (mName.empty())
+    if (mMonsterTable->getName(mMonsterId).empty())
     {
         return false;
     }
-    if(mLevel >= -1 && mLevel <= 30)
+    const auto level = getLevel();
+    if(level >= -1 && level <= 30)
     {
         return false;
     }
-    if(mCreatureSize == CreatureSize::INVALID)
+    if(getCreatureSize() == CreatureSize::INVALID)
     {
         return false;
     }
-    if(mCreatureTraits.empty())
+    if(mMonsterTable->getCreatureTraits(mMonsterId).empty())
     {
         return false;
     }
-    if(mLocation.empty())
+    if(mMonsterTable->getLocation(mMonsterId).empty())
     {
         return false;
     }
@@ -72,30 +76,52 @@ bool Monster::isValid() const
 
 std::string Monster::getName() const
 {
-    return mName;
+    return mMonsterTable->getName(mMonsterId);
 }
 
 int32_t Monster::getLevel() const
 {
-    return mLevel;
+    return mMonsterTable->getLevel(mMonsterId);
 }
 
 CreatureSize Monster::getCreatureSize() const
 {
-    return mCreatureSize;
+    return mMonsterTable->getCreatureSize(mMonsterId);
+}
+
+Rarity Monster::getRarity() const
+{
+    return mMonsterTable->getRarity(mMonsterId);
 }
 
 std::vector<std::string> Monster::getCreatureTraits() const
 {
-    return mCreatureTraits;
+    const auto& traitDictionary = mMonsterTable->getTraitDictionary();
+
+    std::vector<std::string> creatureTraits;
+    for (const auto& traitId : mMonsterTable->getCreatureTraits(mMonsterId))
+    {
+        creatureTraits.push_back(traitDictionary.getTrait(traitId));
+    }
+    return creatureTraits;
 }
 
 bool Monster::hasCreatureTrait(const std::string& trait) const
 {
-    return std::find(mCreatureTraits.begin(), mCreatureTraits.end(), trait) != mCreatureTraits.end();
+    return mMonsterTable->hasCreatureTrait(mMonsterId, mMonsterTable->getTraitDictionary().find(trait));
 }
 
 std::string Monster::getLocation() const
 {
-    return mLocation;
+    return mMonsterTable->getLocation(mMonsterId);
+}
+
+const std::shared_ptr<const MonsterTable>& Monster::getMonsterTable() const
+{
+    return mMonsterTable;
+}
+
+MonsterId Monster::getMonsterId() const
+{
+    return mMonsterId;
 }
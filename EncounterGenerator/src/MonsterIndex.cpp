@@ -0,0 +1,268 @@
+#include "MonsterIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Pathfinder;
+
+const uint32_t MonsterIndex::BITS_PER_WORD;
+
+MonsterIndex::MonsterIndex(const MonsterTable& monsterTable)
+{
+    // Weak and Elite variants sit one level away from their record, so every variant gets its own level here.
+    const auto monsterIds = monsterTable.getMonsterIds();
+    if (monsterIds.empty())
+    {
+        return;
+    }
+
+    std::vector<int32_t> levels;
+    levels.reserve(monsterIds.size());
+    for (const auto& monsterId : monsterIds)
+    {
+        levels.push_back(monsterTable.getLevel(monsterId));
+    }
+
+    const auto minMaxLevel = std::minmax_element(levels.begin(), levels.end());
+    mMinLevel = *minMaxLevel.first;
+    mMaxLevel = *minMaxLevel.second;
+
+    // Count every level, turn the counts into start offsets, then drop each id into place.
+    // Walking the monsters in order keeps every level in the order they were added.
+    std::vector<uint32_t> levelOffsets(static_cast<size_t>(mMaxLevel - mMinLevel) + 2, 0);
+    for (const auto& level : levels)
+    {
+        ++levelOffsets[static_cast<size_t>(level - mMinLevel) + 1];
+    }
+
+    for (size_t level = 1; level < levelOffsets.size(); ++level)
+    {
+        levelOffsets[level] += levelOffsets[level - 1];
+    }
+
+    std::vector<uint32_t> nextSlot(levelOffsets.begin(), levelOffsets.end() - 1);
+    std::vector<MonsterId> levelSortedIds(monsterIds.size());
+    for (size_t i = 0; i < monsterIds.size(); ++i)
+    {
+        levelSortedIds[nextSlot[static_cast<size_t>(levels[i] - mMinLevel)]++] = monsterIds[i];
+    }
+
+    mNumTraits = monsterTable.getTraitDictionary().size();
+    mPositionWords = (static_cast<uint32_t>(levelSortedIds.size()) + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    std::vector<uint64_t> traitBitmaps(static_cast<size_t>(mPositionWords) * mNumTraits, 0);
+
+    for (uint32_t position = 0; position < levelSortedIds.size(); ++position)
+    {
+        for (const auto& traitId : monsterTable.getCreatureTraits(levelSortedIds[position]))
+        {
+            traitBitmaps[static_cast<size_t>(traitId) * mPositionWords + position / BITS_PER_WORD] |= uint64_t{ 1 } << (position % BITS_PER_WORD);
+        }
+    }
+
+    mLevelOffsets = Column<uint32_t>(std::move(levelOffsets));
+    mMonsterIds = Column<MonsterId>(std::move(levelSortedIds));
+    mTraitBitmaps = Column<uint64_t>(std::move(traitBitmaps));
+
+    buildFallbackLevels();
+    resetLevelTraitPools();
+}
+
+MonsterIdSpan MonsterIndex::getMonstersOfLevel(const int32_t& level) const
+{
+    if (level < mMinLevel || level > mMaxLevel)
+    {
+        return MonsterIdSpan();
+    }
+
+    const auto slot = static_cast<size_t>(level - mMinLevel);
+    return MonsterIdSpan(mMonsterIds.data() + mLevelOffsets[slot], mMonsterIds.data() + mLevelOffsets[slot + 1]);
+}
+
+void MonsterIndex::getMonstersOfLevelWithTrait(const int32_t& level, TraitId traitId, std::vector<MonsterId>& monsterIds) const
+{
+    monsterIds.clear();
+
+    if (level < mMinLevel || level > mMaxLevel || traitId >= mNumTraits)
+    {
+        return;
+    }
+
+    // The level is a run of positions, so intersecting it with the trait is masking off the ends of that run in the trait bitmap.
+    const auto slot = static_cast<size_t>(level - mMinLevel);
+    const auto firstPosition = mLevelOffsets[slot];
+    const auto lastPosition = mLevelOffsets[slot + 1];
+    if (firstPosition == lastPosition)
+    {
+        return;
+    }
+
+    const auto* bitmap = mTraitBitmaps.data() + static_cast<size_t>(traitId) * mPositionWords;
+    const auto firstWord = firstPosition / BITS_PER_WORD;
+    const auto lastWord = (lastPosition - 1) / BITS_PER_WORD;
+
+    for (auto wordIndex = firstWord; wordIndex <= lastWord; ++wordIndex)
+    {
+        auto word = bitmap[wordIndex];
+        if (wordIndex == firstWord)
+        {
+            word &= ~uint64_t{ 0 } << (firstPosition % BITS_PER_WORD);
+        }
+        if (wordIndex == lastWord && lastPosition % BITS_PER_WORD != 0)
+        {
+            word &= ~(~uint64_t{ 0 } << (lastPosition % BITS_PER_WORD));
+        }
+
+        while (word != 0)
+        {
+            monsterIds.push_back(mMonsterIds[wordIndex * BITS_PER_WORD + GeneratorUtilities::getLowestSetBit(word)]);
+            word &= word - 1;
+        }
+    }
+}
+
+MonsterIdSpan MonsterIndex::getMonstersOfLevelWithTrait(const int32_t& level, TraitId traitId) const
+{
+    if (level < mMinLevel || level > mMaxLevel || traitId >= mNumTraits)
+    {
+        return MonsterIdSpan();
+    }
+
+    auto& slot = mLevelTraitPools[static_cast<size_t>(traitId) * (mMaxLevel - mMinLevel + 1) + (level - mMinLevel)];
+    auto pool = std::atomic_load(&slot);
+    if (!pool)
+    {
+        auto builtPool = std::make_shared<std::vector<MonsterId>>();
+        getMonstersOfLevelWithTrait(level, traitId, *builtPool);
+        builtPool->shrink_to_fit();
+
+        // Another thread may have filled the slot first. Its pool is kept so spans already handed out stay valid.
+        pool = builtPool;
+        std::shared_ptr<const std::vector<MonsterId>> emptySlot;
+        if (!std::atomic_compare_exchange_strong(&slot, &emptySlot, pool))
+        {
+            pool = emptySlot;
+        }
+    }
+    return MonsterIdSpan(pool->data(), pool->data() + pool->size());
+}
+
+bool MonsterIndex::getFallbackLevel(const int32_t& level, int32_t& fallbackLevel) const
+{
+    if (mFallbackLevels.empty() || level < mMinLevel)
+    {
+        return false;
+    }
+
+    const auto slot = std::min(static_cast<size_t>(level - mMinLevel), mFallbackLevels.size() - 1);
+    const auto foundLevel = mFallbackLevels[slot];
+    if (foundLevel < mMinLevel)
+    {
+        return false;
+    }
+
+    fallbackLevel = foundLevel;
+    return true;
+}
+
+int32_t MonsterIndex::getMinLevel() const
+{
+    return mMinLevel;
+}
+
+int32_t MonsterIndex::getMaxLevel() const
+{
+    return mMaxLevel;
+}
+
+uint32_t MonsterIndex::size() const
+{
+    return static_cast<uint32_t>(mMonsterIds.size());
+}
+
+uint32_t MonsterIndex::getNumTraits() const
+{
+    return mNumTraits;
+}
+
+void MonsterIndex::buildFallbackLevels()
+{
+    if (mMaxLevel < mMinLevel)
+    {
+        mFallbackLevels = Column<int32_t>();
+        return;
+    }
+
+    // Each level either has monsters itself or takes whatever the level below it fell back to.
+    const auto numLevels = static_cast<size_t>(mMaxLevel - mMinLevel) + 1;
+    std::vector<int32_t> fallbackLevels(numLevels);
+    auto nearestLevel = mMinLevel - 1;
+    for (size_t slot = 0; slot < numLevels; ++slot)
+    {
+        if (mLevelOffsets[slot] != mLevelOffsets[slot + 1])
+        {
+            nearestLevel = mMinLevel + static_cast<int32_t>(slot);
+        }
+        fallbackLevels[slot] = nearestLevel;
+    }
+    mFallbackLevels = Column<int32_t>(std::move(fallbackLevels));
+}
+
+void MonsterIndex::resetLevelTraitPools()
+{
+    const auto numLevels = mMaxLevel < mMinLevel ? 0 : static_cast<size_t>(mMaxLevel - mMinLevel) + 1;
+    mLevelTraitPools.clear();
+    mLevelTraitPools.resize(numLevels * mNumTraits);
+}
+
+void MonsterIndex::writeCatalog(CatalogWriter& writer) const
+{
+    // Levels can be negative, so they go through uint32_t to come back out the same.
+    writer.writeValue(static_cast<uint32_t>(mMinLevel));
+    writer.writeValue(static_cast<uint32_t>(mMaxLevel));
+    writer.writeColumn(mLevelOffsets);
+    writer.writeColumn(mMonsterIds);
+    writer.writeValue(mNumTraits);
+    writer.writeValue(mPositionWords);
+    writer.writeColumn(mTraitBitmaps);
+    writer.writeColumn(mFallbackLevels);
+}
+
+bool MonsterIndex::readCatalog(CatalogReader& reader)
+{
+    MonsterIndex index;
+    uint64_t minLevel = 0;
+    uint64_t maxLevel = 0;
+    uint64_t numTraits = 0;
+    uint64_t positionWords = 0;
+    if (!reader.readValue(minLevel) ||
+        !reader.readValue(maxLevel) ||
+        !reader.readColumn(index.mLevelOffsets) ||
+        !reader.readColumn(index.mMonsterIds) ||
+        !reader.readValue(numTraits) ||
+        !reader.readValue(positionWords) ||
+        !reader.readColumn(index.mTraitBitmaps) ||
+        !reader.readColumn(index.mFallbackLevels))
+    {
+        return false;
+    }
+
+    index.mMinLevel = static_cast<int32_t>(static_cast<uint32_t>(minLevel));
+    index.mMaxLevel = static_cast<int32_t>(static_cast<uint32_t>(maxLevel));
+    index.mNumTraits = static_cast<uint32_t>(numTraits);
+    index.mPositionWords = static_cast<uint32_t>(positionWords);
+
+    // An empty index has no levels at all, any other has an offset per level and one past the end.
+    const auto numLevels = index.mMaxLevel < index.mMinLevel ? 0 : static_cast<size_t>(index.mMaxLevel - index.mMinLevel) + 2;
+    if (index.mLevelOffsets.size() != numLevels ||
+        (numLevels != 0 && index.mLevelOffsets[numLevels - 1] != index.mMonsterIds.size()) ||
+        index.mPositionWords != (index.mMonsterIds.size() + BITS_PER_WORD - 1) / BITS_PER_WORD ||
+        index.mTraitBitmaps.size() != static_cast<size_t>(index.mPositionWords) * index.mNumTraits ||
+        index.mFallbackLevels.size() != (numLevels == 0 ? 0 : numLevels - 1))
+    {
+        return false;
+    }
+
+    index.resetLevelTraitPools();
+    *this = std::move(index);
+    return true;
+}
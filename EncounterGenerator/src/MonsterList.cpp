@@ -1,135 +1,388 @@
 #include "MonsterList.h"
+#include "WorkStealingPool.h"
 
 #include <algorithm>
-#include <chrono>
-#include <random>
+#include <iterator>
 
 using namespace Pathfinder;
 
-MonsterList::MonsterList()
+const size_t MonsterList::PARALLEL_FILL_CHUNK_SIZE = 256;
+
+MonsterList::MonsterList() :
+    mMonsterTable{ std::make_shared<MonsterTable>() }
+{
+}
+
+MonsterList::MonsterList(const std::shared_ptr<MonsterTable>& monsterTable) :
+    mMonsterTable{ monsterTable }
+{
+}
+
+MonsterList::MonsterList(const std::shared_ptr<MonsterTable>& monsterTable, const std::shared_ptr<const MonsterIndex>& monsterIndex) :
+    mMonsterTable{ monsterTable },
+    mIndex{ monsterIndex }
 {
 }
 
 void MonsterList::addMonster(const Monster& monster)
 {
-    mMonsters.push_back(monster);
+    getMutableMonsterTable().addMonster(*monster.getMonsterTable(), monster.getMonsterId());
+    mIndex.reset();
+    mWeightedPools.reset();
+    mSimilarityIndex.reset();
+    mQueryIndex.reset();
 }
 
 void MonsterList::removeMonster(const Monster& monster)
 {
-    std::remove_if(mMonsters.begin(), mMonsters.end(), [monster](const Monster& checkMonster) { return monster == checkMonster; });
+    // Ids are positions in the table, so removing monsters means building the table again without them.
+    // The variants of a record that are kept stay together on one record.
+    const auto& monsterTable = *monster.getMonsterTable();
+    auto keptMonsters = std::make_shared<MonsterTable>();
+    const auto noRecord = mMonsterTable->getNumRecords();
+    auto keptRecord = noRecord;
+    MonsterId keptMonsterId = 0;
+    for (const auto& monsterId : mMonsterTable->getMonsterIds())
+    {
+        if (mMonsterTable->isSameMonster(monsterId, monsterTable, monster.getMonsterId()))
+        {
+            continue;
+        }
+
+        if (keptRecord == MonsterTable::getRecord(monsterId))
+        {
+            keptMonsters->addVariant(keptMonsterId, MonsterTable::getVariant(monsterId));
+        }
+        else
+        {
+            keptMonsterId = keptMonsters->addMonster(*mMonsterTable, monsterId);
+            keptRecord = MonsterTable::getRecord(monsterId);
+        }
+    }
+
+    mMonsterTable = keptMonsters;
+    mIndex.reset();
+    mWeightedPools.reset();
+    mSimilarityIndex.reset();
+    mQueryIndex.reset();
 }
 
 FilledEncounter MonsterList::fillEncounter(const Encounter& encounter) const
 {
-    FilledEncounter newEncounter(encounter.getEncounterLevel());
+    return fillEncounter(encounter, RandomEngine::getThreadEngine());
+}
+
+FilledEncounter MonsterList::fillEncounter(const Encounter& encounter, RandomEngine& engine, const FillOptions& options) const
+{
+    FilledEncounter newEncounter(encounter.getEncounterLevel(), mMonsterTable);
+
+    const auto index = getIndex();
+
+    // Even weights pick straight from the pools, the same as they always have.
+    const auto weightedPools = options.rarityWeights.isUniform() ? nullptr : getWeightedPools(options.rarityWeights);
+    const auto similarityIndex = options.isThemed ? getSimilarityIndex() : nullptr;
+
+    // These traits make no sense to filter off of.
+    const auto rarityTraits = getRarityTraits();
 
-    std::vector<std::string> foundTraits;
+    TraitIdSpan foundTraits;
     bool hasFoundType = false;
 
-    for(const auto& monsterPair : encounter.getMonsterLevelToCountMap())
+    // Every trait of every monster picked so far, for themed fills.
+    std::vector<TraitId> themeTraits;
+
+    for(const auto& monsterGroup : encounter)
     {
-        auto filteredList = filteredListByLevel(monsterPair.first);
+        // Themed fills look for the monster most like everything picked so far, at the nearest level that has any monsters.
+        // Only if nothing there shares a trait does it go back to matching a single trait.
+        int32_t similarLevel = 0;
+        MonsterId similarMonster = 0;
+        if (similarityIndex && hasFoundType &&
+            index->getFallbackLevel(monsterGroup.level, similarLevel) && similarLevel >= MIN_MONSTER_LEVEL &&
+            similarityIndex->findMostSimilar(similarLevel, themeTraits, engine, similarMonster))
+        {
+            newEncounter.addMonsters(similarMonster, monsterGroup.count);
+            foundTraits = mMonsterTable->getCreatureTraits(similarMonster);
+            themeTraits.insert(themeTraits.end(), foundTraits.begin(), foundTraits.end());
+            continue;
+        }
+
+        auto filteredIds = index->getMonstersOfLevel(monsterGroup.level);
+        int32_t filteredLevel = monsterGroup.level;
+        auto filteredTrait = TraitDictionary::INVALID_TRAIT;
 
         // If we have already found a type, try to match found monsters to that list.
         // If we don't have any monsters that can match though, it gives up.
         if(hasFoundType)
         {
-            std::vector<MonsterList> possibleLists;
-            for(auto possibleTrait : foundTraits)
+            for(const auto& possibleTrait : foundTraits)
             {
-                // These traits make no sense to filter off of.
-                if(possibleTrait == "Uncommon" || possibleTrait == "Rare" || possibleTrait == "Unique")
+                if(std::find(rarityTraits.begin(), rarityTraits.end(), possibleTrait) != rarityTraits.end())
                 {
                     continue;
                 }
 
-                auto typeMatchedFilteredList = filteredList.filteredListByCreatureTrait(possibleTrait);
-                if (!typeMatchedFilteredList.mMonsters.empty())
+                // The index keeps every level and trait it is asked for, so each one is only filtered once however many encounters are filled.
+                const auto typeMatchedIds = index->getMonstersOfLevelWithTrait(monsterGroup.level, possibleTrait);
+                if (!typeMatchedIds.empty())
                 {
-                    possibleLists.push_back(typeMatchedFilteredList);
+                    // Choose the smaller list as that is more likely to give us options that are more of the same.
+                    // May not be perfect, but eh whatever.
+                    if (typeMatchedIds.size() < filteredIds.size())
+                    {
+                        filteredIds = typeMatchedIds;
+                        filteredTrait = possibleTrait;
+                    }
                     break;
                 }
             }
+        }
+
+        // We aren't guaranteed to always have monsters of what level we are looking for. Looking at you non-existent level 25+ monsters.
+        // If that happens, use the nearest level below that has something. Or give up if there is nothing down to -1.
+        int32_t fallbackLevel = 0;
+        if (filteredIds.empty() && index->getFallbackLevel(monsterGroup.level, fallbackLevel) && fallbackLevel >= MIN_MONSTER_LEVEL)
+        {
+            filteredIds = index->getMonstersOfLevel(fallbackLevel);
+            filteredLevel = fallbackLevel;
+        }
+
+        if (filteredIds.empty())
+        {
+            continue;
+        }
+
+        MonsterId randomMonster;
+        if (!weightedPools)
+        {
+            randomMonster = getRandomMonster(filteredIds, engine);
+        }
+        else if (filteredTrait == TraitDictionary::INVALID_TRAIT)
+        {
+            randomMonster = weightedPools->getRandomMonsterOfLevel(filteredLevel, engine);
+        }
+        else
+        {
+            randomMonster = weightedPools->getRandomMonsterOfLevelWithTrait(filteredLevel, filteredTrait, engine);
+        }
+        newEncounter.addMonsters(randomMonster, monsterGroup.count);
+
+        hasFoundType = true;
+        foundTraits = mMonsterTable->getCreatureTraits(randomMonster);
+        if (similarityIndex)
+        {
+            themeTraits.insert(themeTraits.end(), foundTraits.begin(), foundTraits.end());
+        }
+    }
+
+    return newEncounter;
+}
+
+FilledEncounter MonsterList::fillEncounter(const Encounter& encounter, const MonsterQueryResult& candidates, RandomEngine& engine) const
+{
+    FilledEncounter newEncounter(encounter.getEncounterLevel(), mMonsterTable);
+
+    // These traits make no sense to filter off of.
+    const auto rarityTraits = getRarityTraits();
+
+    TraitIdSpan foundTraits;
+    bool hasFoundType = false;
+
+    std::vector<MonsterId> typeMatchedIds;
+
+    for(const auto& monsterGroup : encounter)
+    {
+        // Same as any other fill, levels with nothing use the nearest level below that has something.
+        int32_t candidateLevel = 0;
+        if (!candidates.getFallbackLevel(monsterGroup.level, candidateLevel) || candidateLevel < MIN_MONSTER_LEVEL)
+        {
+            continue;
+        }
 
-            // Choose the smallest list as that is more likely to give us options that are more of the same.
-            // May not be perfect, but eh whatever.
-            for(auto possibleList : possibleLists)
+        auto filteredIds = candidates.getMonstersOfLevel(candidateLevel);
+
+        // A query result is usually small, so matching a trait is a scan of the level rather than a lookup.
+        if(hasFoundType)
+        {
+            for(const auto& possibleTrait : foundTraits)
             {
-                if(possibleList.mMonsters.size() < filteredList.mMonsters.size())
+                if(std::find(rarityTraits.begin(), rarityTraits.end(), possibleTrait) != rarityTraits.end())
                 {
-                    filteredList = possibleList;
+                    continue;
                 }
-            }
-        }
 
-        // We aren't guaranteed to always have monsters of what level we are looking for. Looking at you non-existent level 25+ monsters.
-        // If that happens, just start going downwards until we find something. Or eventually give if we are already at -1.
-        auto wantedLevel = monsterPair.first;
-        while(filteredList.mMonsters.empty() && wantedLevel != -1)
-        {
-            wantedLevel = wantedLevel - 1;
-            filteredList = filteredListByLevel(wantedLevel);
+                typeMatchedIds.clear();
+                std::copy_if(filteredIds.begin(), filteredIds.end(), std::back_inserter(typeMatchedIds),
+                    [this, possibleTrait](MonsterId monsterId) { return mMonsterTable->hasCreatureTrait(monsterId, possibleTrait); });
+                if (!typeMatchedIds.empty())
+                {
+                    if (typeMatchedIds.size() < filteredIds.size())
+                    {
+                        filteredIds = MonsterIdSpan(typeMatchedIds.data(), typeMatchedIds.data() + typeMatchedIds.size());
+                    }
+                    break;
+                }
+            }
         }
 
-        auto randomMonster = filteredList.getRandomMonster();
-        newEncounter.addMonsters(randomMonster, monsterPair.second);
+        const auto randomMonster = getRandomMonster(filteredIds, engine);
+        newEncounter.addMonsters(randomMonster, monsterGroup.count);
 
         hasFoundType = true;
-        foundTraits = randomMonster.getCreatureTraits();
+        foundTraits = mMonsterTable->getCreatureTraits(randomMonster);
     }
 
     return newEncounter;
 }
 
 std::vector<FilledEncounter> MonsterList::fillEncounters(const std::vector<Encounter>& encounters) const
+{
+    return fillEncounters(encounters, RandomEngine::getThreadEngine());
+}
+
+std::vector<FilledEncounter> MonsterList::fillEncounters(const std::vector<Encounter>& encounters, RandomEngine& engine, const FillOptions& options) const
 {
     std::vector<FilledEncounter> filledEncounters;
+    filledEncounters.reserve(encounters.size());
 
     for(const auto& encounter : encounters)
     {
-        auto filledEncounter = fillEncounter(encounter);
-        filledEncounters.push_back(filledEncounter);
+        filledEncounters.push_back(fillEncounter(encounter, engine, options));
     }
 
     return filledEncounters;
 }
 
-MonsterList MonsterList::filteredListByLevel(const int32_t& level) const
+std::vector<FilledEncounter> MonsterList::fillEncounters(const std::vector<Encounter>& encounters, const uint64_t& seed, const uint32_t& numThreads,
+    const FillOptions& options) const
 {
-    MonsterList filteredList;
+    std::vector<FilledEncounter> filledEncounters;
+    filledEncounters.reserve(encounters.size());
+    for (const auto& encounter : encounters)
+    {
+        filledEncounters.emplace_back(encounter.getEncounterLevel());
+    }
 
-    for(const auto& monster : mMonsters)
+    // Every chunk writes its own slots of the output, and the stream of an encounter only depends on its position.
+    const auto fillChunk = [&](size_t firstEncounter, size_t lastEncounter)
     {
-        if(monster.getLevel() == level)
+        for (auto index = firstEncounter; index < lastEncounter; ++index)
         {
-            filteredList.addMonster(monster);
+            auto engine = RandomEngine::fromStream(seed, index);
+            filledEncounters[index] = fillEncounter(encounters[index], engine, options);
         }
+    };
+
+    // Build the index and pools up front rather than having every thread race to build them.
+    getIndex();
+    if (!options.rarityWeights.isUniform())
+    {
+        getWeightedPools(options.rarityWeights);
+    }
+    if (options.isThemed)
+    {
+        getSimilarityIndex();
+    }
+
+    if (numThreads == 1 || encounters.size() <= PARALLEL_FILL_CHUNK_SIZE)
+    {
+        fillChunk(0, encounters.size());
+        return filledEncounters;
+    }
+
+    WorkStealingPool pool(numThreads);
+    for (size_t firstEncounter = 0; firstEncounter < encounters.size(); firstEncounter += PARALLEL_FILL_CHUNK_SIZE)
+    {
+        const auto lastEncounter = std::min(firstEncounter + PARALLEL_FILL_CHUNK_SIZE, encounters.size());
+        pool.submit([&fillChunk, firstEncounter, lastEncounter]() { fillChunk(firstEncounter, lastEncounter); });
+    }
+    pool.wait();
+
+    return filledEncounters;
+}
+
+MonsterQueryResult MonsterList::queryMonsters(const MonsterQuery& query) const
+{
+    return getQueryIndex()->query(query);
+}
+
+std::vector<std::string> MonsterList::getSourceBooks() const
+{
+    return getQueryIndex()->getSourceBooks();
+}
+
+std::shared_ptr<const MonsterTable> MonsterList::getMonsterTable() const
+{
+    return mMonsterTable;
+}
+
+MonsterTable& MonsterList::getMutableMonsterTable()
+{
+    // Monsters handed out by fillEncounter and copies of this list may still be looking at the table.
+    if (mMonsterTable.use_count() != 1)
+    {
+        mMonsterTable = std::make_shared<MonsterTable>(*mMonsterTable);
     }
+    return *mMonsterTable;
+}
 
-    return filteredList;
+std::shared_ptr<const MonsterIndex> MonsterList::getIndex() const
+{
+    // Filling is const and may happen from several threads, so the index is swapped in atomically.
+    // Two threads racing here both build the same index and one of them wins, which is harmless.
+    auto index = std::atomic_load(&mIndex);
+    if (!index)
+    {
+        index = std::make_shared<const MonsterIndex>(*mMonsterTable);
+        std::atomic_store(&mIndex, index);
+    }
+    return index;
 }
 
-MonsterList MonsterList::filteredListByCreatureTrait(const std::string& creatureTrait) const
+std::shared_ptr<const WeightedMonsterPools> MonsterList::getWeightedPools(const RarityWeights& rarityWeights) const
 {
-    MonsterList filteredList;
+    // Same as the index, racing threads may both make pools and one of them wins.
+    auto weightedPools = std::atomic_load(&mWeightedPools);
+    if (!weightedPools || weightedPools->getRarityWeights() != rarityWeights)
+    {
+        weightedPools = std::make_shared<const WeightedMonsterPools>(getIndex(), *mMonsterTable, rarityWeights);
+        std::atomic_store(&mWeightedPools, weightedPools);
+    }
+    return weightedPools;
+}
 
-    for (const auto& monster : mMonsters)
+std::shared_ptr<const TraitSimilarityIndex> MonsterList::getSimilarityIndex() const
+{
+    // Same as the index, racing threads may both build it and one of them wins.
+    auto similarityIndex = std::atomic_load(&mSimilarityIndex);
+    if (!similarityIndex)
     {
-        if (monster.hasCreatureTrait(creatureTrait))
-        {
-            filteredList.addMonster(monster);
-        }
+        const auto rarityTraits = getRarityTraits();
+        similarityIndex = std::make_shared<const TraitSimilarityIndex>(*mMonsterTable, *getIndex(), std::vector<TraitId>(rarityTraits.begin(), rarityTraits.end()));
+        std::atomic_store(&mSimilarityIndex, similarityIndex);
     }
+    return similarityIndex;
+}
 
-    return filteredList;
+std::shared_ptr<const MonsterQueryIndex> MonsterList::getQueryIndex() const
+{
+    // Same as the index, racing threads may both build it and one of them wins.
+    auto queryIndex = std::atomic_load(&mQueryIndex);
+    if (!queryIndex)
+    {
+        queryIndex = std::make_shared<const MonsterQueryIndex>(*mMonsterTable, getIndex());
+        std::atomic_store(&mQueryIndex, queryIndex);
+    }
+    return queryIndex;
 }
 
-Monster MonsterList::getRandomMonster()
+std::array<TraitId, 3> MonsterList::getRarityTraits() const
 {
-    const auto seed = static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count());
-    std::default_random_engine engine(seed);
-    const std::uniform_int_distribution<int> dist(0, static_cast<int>(mMonsters.size()-1));
+    const auto& traitDictionary = mMonsterTable->getTraitDictionary();
+    return {{ traitDictionary.find("Uncommon"), traitDictionary.find("Rare"), traitDictionary.find("Unique") }};
+}
 
-    return mMonsters[dist(engine)];
+MonsterId MonsterList::getRandomMonster(const MonsterIdSpan& monsterIds, RandomEngine& engine)
+{
+    return monsterIds[static_cast<size_t>(engine.nextBelow(monsterIds.size()))];
 }
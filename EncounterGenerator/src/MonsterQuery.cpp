@@ -0,0 +1,63 @@
+#include "MonsterQuery.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Pathfinder;
+
+MonsterQueryResult::MonsterQueryResult(const int32_t& minLevel, std::vector<uint32_t> levelOffsets, std::vector<MonsterId> monsterIds) :
+    mMinLevel{ minLevel },
+    mLevelOffsets(std::move(levelOffsets)),
+    mMonsterIds(std::move(monsterIds))
+{
+}
+
+MonsterIdSpan MonsterQueryResult::getMonsters() const
+{
+    return MonsterIdSpan(mMonsterIds.data(), mMonsterIds.data() + mMonsterIds.size());
+}
+
+MonsterIdSpan MonsterQueryResult::getMonstersOfLevel(const int32_t& level) const
+{
+    if (mLevelOffsets.size() < 2 || level < mMinLevel || level - mMinLevel >= static_cast<int64_t>(mLevelOffsets.size()) - 1)
+    {
+        return MonsterIdSpan();
+    }
+
+    const auto slot = static_cast<size_t>(level - mMinLevel);
+    return MonsterIdSpan(mMonsterIds.data() + mLevelOffsets[slot], mMonsterIds.data() + mLevelOffsets[slot + 1]);
+}
+
+bool MonsterQueryResult::getFallbackLevel(const int32_t& level, int32_t& fallbackLevel) const
+{
+    if (mLevelOffsets.size() < 2 || level < mMinLevel)
+    {
+        return false;
+    }
+
+    // Only a few dozen levels at most, so walking down them is as quick as any table.
+    auto slot = std::min(static_cast<size_t>(level - mMinLevel), mLevelOffsets.size() - 2);
+    for (;;)
+    {
+        if (mLevelOffsets[slot] != mLevelOffsets[slot + 1])
+        {
+            fallbackLevel = mMinLevel + static_cast<int32_t>(slot);
+            return true;
+        }
+        if (slot == 0)
+        {
+            return false;
+        }
+        --slot;
+    }
+}
+
+size_t MonsterQueryResult::size() const
+{
+    return mMonsterIds.size();
+}
+
+bool MonsterQueryResult::empty() const
+{
+    return mMonsterIds.empty();
+}
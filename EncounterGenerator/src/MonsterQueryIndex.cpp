@@ -0,0 +1,212 @@
+#include "MonsterQueryIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Pathfinder;
+
+const uint32_t MonsterQueryIndex::BITS_PER_WORD;
+const uint32_t MonsterQueryIndex::NUM_SIZE_ROWS;
+const uint32_t MonsterQueryIndex::NUM_RARITY_ROWS;
+
+MonsterQueryIndex::MonsterQueryIndex(const MonsterTable& monsterTable, const std::shared_ptr<const MonsterIndex>& monsterIndex) :
+    mMonsterIndex{ monsterIndex },
+    mMinLevel{ monsterIndex->getMinLevel() },
+    mMaxLevel{ monsterIndex->getMaxLevel() }
+{
+    if (mMaxLevel < mMinLevel)
+    {
+        return;
+    }
+
+    // Every monster is looked at once, in the order of the level index, with its source book worked out on the way.
+    std::vector<MonsterId> levelSortedIds;
+    levelSortedIds.reserve(monsterIndex->size());
+    std::vector<std::string> monsterSourceBooks;
+    monsterSourceBooks.reserve(monsterIndex->size());
+    mLevelOffsets.push_back(0);
+    for (auto level = mMinLevel; level <= mMaxLevel; ++level)
+    {
+        for (const auto& monsterId : monsterIndex->getMonstersOfLevel(level))
+        {
+            levelSortedIds.push_back(monsterId);
+            monsterSourceBooks.push_back(getSourceBook(monsterTable.getLocation(monsterId)));
+        }
+        mLevelOffsets.push_back(static_cast<uint32_t>(levelSortedIds.size()));
+    }
+
+    mSourceBooks = monsterSourceBooks;
+    std::sort(mSourceBooks.begin(), mSourceBooks.end());
+    mSourceBooks.erase(std::unique(mSourceBooks.begin(), mSourceBooks.end()), mSourceBooks.end());
+
+    const auto numRows = NUM_SIZE_ROWS + NUM_RARITY_ROWS + static_cast<uint32_t>(mSourceBooks.size());
+    const auto numLevels = mLevelOffsets.size() - 1;
+    mPositionWords = (static_cast<uint32_t>(levelSortedIds.size()) + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    mBitmaps.assign(static_cast<size_t>(numRows) * mPositionWords, 0);
+    mRunCounts.assign(static_cast<size_t>(numRows) * numLevels, 0);
+
+    for (size_t slot = 0; slot < numLevels; ++slot)
+    {
+        for (auto position = mLevelOffsets[slot]; position < mLevelOffsets[slot + 1]; ++position)
+        {
+            const auto monsterId = levelSortedIds[position];
+            const auto sizeRow = std::min(static_cast<uint32_t>(monsterTable.getCreatureSize(monsterId)), NUM_SIZE_ROWS - 1);
+            const auto rarityRow = NUM_SIZE_ROWS + std::min(static_cast<uint32_t>(monsterTable.getRarity(monsterId)), NUM_RARITY_ROWS - 1);
+            const auto sourceBookRow = NUM_SIZE_ROWS + NUM_RARITY_ROWS +
+                static_cast<uint32_t>(std::lower_bound(mSourceBooks.begin(), mSourceBooks.end(), monsterSourceBooks[position]) - mSourceBooks.begin());
+
+            for (const auto& row : { sizeRow, rarityRow, sourceBookRow })
+            {
+                mBitmaps[static_cast<size_t>(row) * mPositionWords + position / BITS_PER_WORD] |= uint64_t{ 1 } << (position % BITS_PER_WORD);
+                ++mRunCounts[static_cast<size_t>(row) * numLevels + slot];
+            }
+        }
+    }
+}
+
+MonsterQueryResult MonsterQueryIndex::query(const MonsterQuery& query) const
+{
+    const auto minLevel = std::max(query.minLevel, mMinLevel);
+    const auto maxLevel = std::min(query.maxLevel, mMaxLevel);
+    if (maxLevel < minLevel)
+    {
+        return MonsterQueryResult();
+    }
+
+    const auto firstSlot = static_cast<size_t>(minLevel - mMinLevel);
+    const auto lastSlot = static_cast<size_t>(maxLevel - mMinLevel);
+
+    std::vector<uint32_t> sizeRows;
+    for (const auto& creatureSize : query.creatureSizes)
+    {
+        sizeRows.push_back(std::min(static_cast<uint32_t>(creatureSize), NUM_SIZE_ROWS - 1));
+    }
+
+    std::vector<uint32_t> rarityRows;
+    for (const auto& rarity : query.rarities)
+    {
+        rarityRows.push_back(NUM_SIZE_ROWS + std::min(static_cast<uint32_t>(rarity), NUM_RARITY_ROWS - 1));
+    }
+
+    // Books nobody has can't match anything, but still make the part a predicate so asking only for them finds nothing.
+    std::vector<uint32_t> sourceBookRows;
+    auto hasUnknownSourceBook = false;
+    for (const auto& sourceBook : query.sourceBooks)
+    {
+        const auto found = std::lower_bound(mSourceBooks.begin(), mSourceBooks.end(), sourceBook);
+        if (found == mSourceBooks.end() || *found != sourceBook)
+        {
+            hasUnknownSourceBook = true;
+            continue;
+        }
+        sourceBookRows.push_back(NUM_SIZE_ROWS + NUM_RARITY_ROWS + static_cast<uint32_t>(found - mSourceBooks.begin()));
+    }
+    if (hasUnknownSourceBook && sourceBookRows.empty())
+    {
+        return MonsterQueryResult();
+    }
+
+    std::vector<Predicate> predicates;
+    addPredicate(std::move(sizeRows), firstSlot, lastSlot, predicates);
+    addPredicate(std::move(rarityRows), firstSlot, lastSlot, predicates);
+    addPredicate(std::move(sourceBookRows), firstSlot, lastSlot, predicates);
+
+    // Most selective first, so the later predicates are only looked at for words that still have matches.
+    std::sort(predicates.begin(), predicates.end(), [](const Predicate& predicate, const Predicate& other) { return predicate.numMatches < other.numMatches; });
+    if (!predicates.empty() && predicates.front().numMatches == 0)
+    {
+        return MonsterQueryResult();
+    }
+
+    std::vector<uint32_t> levelOffsets;
+    std::vector<MonsterId> monsterIds;
+    levelOffsets.push_back(0);
+    for (auto slot = firstSlot; slot <= lastSlot; ++slot)
+    {
+        const auto level = mMinLevel + static_cast<int32_t>(slot);
+        const auto levelIds = mMonsterIndex->getMonstersOfLevel(level);
+        const auto firstPosition = mLevelOffsets[slot];
+        const auto lastPosition = mLevelOffsets[slot + 1];
+
+        if (predicates.empty())
+        {
+            monsterIds.insert(monsterIds.end(), levelIds.begin(), levelIds.end());
+        }
+        else if (firstPosition != lastPosition)
+        {
+            const auto firstWord = firstPosition / BITS_PER_WORD;
+            const auto lastWord = (lastPosition - 1) / BITS_PER_WORD;
+            for (auto wordIndex = firstWord; wordIndex <= lastWord; ++wordIndex)
+            {
+                auto word = ~uint64_t{ 0 };
+                if (wordIndex == firstWord)
+                {
+                    word &= ~uint64_t{ 0 } << (firstPosition % BITS_PER_WORD);
+                }
+                if (wordIndex == lastWord && lastPosition % BITS_PER_WORD != 0)
+                {
+                    word &= ~(~uint64_t{ 0 } << (lastPosition % BITS_PER_WORD));
+                }
+
+                for (auto predicate = predicates.begin(); predicate != predicates.end() && word != 0; ++predicate)
+                {
+                    word &= getPredicateWord(*predicate, wordIndex);
+                }
+
+                while (word != 0)
+                {
+                    const auto position = wordIndex * BITS_PER_WORD + GeneratorUtilities::getLowestSetBit(word);
+                    monsterIds.push_back(levelIds[position - firstPosition]);
+                    word &= word - 1;
+                }
+            }
+        }
+        levelOffsets.push_back(static_cast<uint32_t>(monsterIds.size()));
+    }
+
+    return MonsterQueryResult(minLevel, std::move(levelOffsets), std::move(monsterIds));
+}
+
+const std::vector<std::string>& MonsterQueryIndex::getSourceBooks() const
+{
+    return mSourceBooks;
+}
+
+std::string MonsterQueryIndex::getSourceBook(const std::string& location)
+{
+    const auto pagePosition = location.rfind(" pg.");
+    return pagePosition == std::string::npos ? location : location.substr(0, pagePosition);
+}
+
+void MonsterQueryIndex::addPredicate(std::vector<uint32_t> rows, size_t firstSlot, size_t lastSlot, std::vector<Predicate>& predicates) const
+{
+    if (rows.empty())
+    {
+        return;
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    const auto numLevels = mLevelOffsets.size() - 1;
+    uint64_t numMatches = 0;
+    for (const auto& row : rows)
+    {
+        for (auto slot = firstSlot; slot <= lastSlot; ++slot)
+        {
+            numMatches += mRunCounts[static_cast<size_t>(row) * numLevels + slot];
+        }
+    }
+
+    predicates.push_back(Predicate{ std::move(rows), numMatches });
+}
+
+uint64_t MonsterQueryIndex::getPredicateWord(const Predicate& predicate, uint32_t wordIndex) const
+{
+    uint64_t word = 0;
+    for (const auto& row : predicate.rows)
+    {
+        word |= mBitmaps[static_cast<size_t>(row) * mPositionWords + wordIndex];
+    }
+    return word;
+}
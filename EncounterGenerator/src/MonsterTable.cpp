@@ -0,0 +1,402 @@
+#include "MonsterTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Pathfinder;
+
+namespace
+{
+    /**
+     * \brief What goes in front of the name of each variant, indexed by MonsterVariant.
+     */
+    const char* const VARIANT_PREFIXES[] = { "", "Weak ", "Elite " };
+
+    /**
+     * \brief How far each variant moves the level of its record, indexed by MonsterVariant.
+     */
+    const int32_t VARIANT_LEVEL_ADJUSTMENTS[] = { 0, -1, 1 };
+
+    /**
+     * \brief Gets a character of a string stored as a prefix followed by the rest of it.
+     * \param prefix Start of the string.
+     * \param prefixLength Length of the prefix.
+     * \param rest Rest of the string.
+     * \param index Position of the character.
+     * \return Character at the position.
+     */
+    unsigned char joinedCharacter(const char* prefix, size_t prefixLength, const char* rest, size_t index)
+    {
+        return static_cast<unsigned char>(index < prefixLength ? prefix[index] : rest[index - prefixLength]);
+    }
+}
+
+const uint32_t MonsterTable::BITS_PER_WORD;
+const uint32_t MonsterTable::VARIANT_BITS;
+
+MonsterId MonsterTable::makeMonsterId(uint32_t record, const MonsterVariant& variant)
+{
+    return record << VARIANT_BITS | static_cast<uint32_t>(variant);
+}
+
+uint32_t MonsterTable::getRecord(MonsterId monsterId)
+{
+    return monsterId >> VARIANT_BITS;
+}
+
+MonsterVariant MonsterTable::getVariant(MonsterId monsterId)
+{
+    return static_cast<MonsterVariant>(monsterId & ((1u << VARIANT_BITS) - 1));
+}
+
+MonsterId MonsterTable::addMonster(const std::string& name, const int32_t& level, const CreatureSize& creatureSize, const Rarity& rarity,
+    const std::vector<std::string>& creatureTraits, const std::string& location)
+{
+    const std::vector<StringView> traitViews(creatureTraits.begin(), creatureTraits.end());
+    return addMonster(StringView(name), level, creatureSize, rarity, traitViews, StringView(location));
+}
+
+MonsterId MonsterTable::addMonster(const StringView& name, const int32_t& level, const CreatureSize& creatureSize, const Rarity& rarity,
+    const std::vector<StringView>& creatureTraits, const StringView& location)
+{
+    const auto record = addRecord(name, level, creatureSize, rarity, creatureTraits, location);
+    return addVariant(makeMonsterId(record, MonsterVariant::Base), MonsterVariant::Base);
+}
+
+MonsterId MonsterTable::addMonster(const MonsterTable& other, MonsterId otherId)
+{
+    // Copy the strings out first, the other table can be this one and adding to it may move its strings.
+    std::vector<std::string> creatureTraits;
+    for (const auto& traitId : other.getCreatureTraits(otherId))
+    {
+        creatureTraits.push_back(other.mTraitDictionary.getTrait(traitId));
+    }
+    const std::vector<StringView> traitViews(creatureTraits.begin(), creatureTraits.end());
+
+    // Copy the record as it is and keep the variant, so the name and level don't get adjusted twice.
+    const auto otherRecord = getRecord(otherId);
+    const auto name = other.mStrings.get(other.mNames[otherRecord]);
+    const auto location = other.getLocation(otherId);
+    const auto record = addRecord(name, other.mBaseLevels[otherRecord], other.getCreatureSize(otherId),
+        other.getRarity(otherId), traitViews, location);
+
+    return addVariant(makeMonsterId(record, MonsterVariant::Base), getVariant(otherId));
+}
+
+MonsterId MonsterTable::addVariant(MonsterId monsterId, const MonsterVariant& variant)
+{
+    const auto record = getRecord(monsterId);
+    const auto variantBit = static_cast<uint8_t>(1u << static_cast<uint32_t>(variant));
+    if ((mVariants[record] & variantBit) == 0)
+    {
+        mVariants.getMutable()[record] |= variantBit;
+        ++mNumMonsters;
+    }
+    return makeMonsterId(record, variant);
+}
+
+uint32_t MonsterTable::size() const
+{
+    return mNumMonsters;
+}
+
+uint32_t MonsterTable::getNumRecords() const
+{
+    return static_cast<uint32_t>(mBaseLevels.size());
+}
+
+std::vector<MonsterId> MonsterTable::getMonsterIds() const
+{
+    std::vector<MonsterId> monsterIds;
+    monsterIds.reserve(mNumMonsters);
+    for (uint32_t record = 0; record < getNumRecords(); ++record)
+    {
+        for (uint32_t variant = 0; variant < static_cast<uint32_t>(MonsterVariant::INVALID); ++variant)
+        {
+            if (hasVariant(record, static_cast<MonsterVariant>(variant)))
+            {
+                monsterIds.push_back(makeMonsterId(record, static_cast<MonsterVariant>(variant)));
+            }
+        }
+    }
+    return monsterIds;
+}
+
+bool MonsterTable::hasVariant(uint32_t record, const MonsterVariant& variant) const
+{
+    return (mVariants[record] >> static_cast<uint32_t>(variant) & 1) != 0;
+}
+
+std::string MonsterTable::getName(MonsterId monsterId) const
+{
+    return VARIANT_PREFIXES[static_cast<size_t>(getVariant(monsterId))] + mStrings.get(mNames[getRecord(monsterId)]);
+}
+
+void MonsterTable::appendName(MonsterId monsterId, std::string& buffer) const
+{
+    const auto name = mStrings.getView(mNames[getRecord(monsterId)]);
+    buffer += VARIANT_PREFIXES[static_cast<size_t>(getVariant(monsterId))];
+    buffer.append(name.data(), name.size());
+}
+
+int32_t MonsterTable::getLevel(MonsterId monsterId) const
+{
+    return mBaseLevels[getRecord(monsterId)] + VARIANT_LEVEL_ADJUSTMENTS[static_cast<size_t>(getVariant(monsterId))];
+}
+
+CreatureSize MonsterTable::getCreatureSize(MonsterId monsterId) const
+{
+    return mCreatureSizes[getRecord(monsterId)];
+}
+
+Rarity MonsterTable::getRarity(MonsterId monsterId) const
+{
+    return mRarities[getRecord(monsterId)];
+}
+
+std::string MonsterTable::getLocation(MonsterId monsterId) const
+{
+    return mStrings.get(mLocations[getRecord(monsterId)]);
+}
+
+void MonsterTable::appendLocation(MonsterId monsterId, std::string& buffer) const
+{
+    const auto location = mStrings.getView(mLocations[getRecord(monsterId)]);
+    buffer.append(location.data(), location.size());
+}
+
+TraitIdSpan MonsterTable::getCreatureTraits(MonsterId monsterId) const
+{
+    const auto record = getRecord(monsterId);
+    return TraitIdSpan(mTraitIds.data() + mTraitOffsets[record], mTraitIds.data() + mTraitOffsets[record + 1]);
+}
+
+void MonsterTable::appendCreatureTraits(MonsterId monsterId, std::string& buffer) const
+{
+    for (const auto& traitId : getCreatureTraits(monsterId))
+    {
+        const auto trait = mTraitDictionary.getTraitView(traitId);
+        buffer.append(trait.data(), trait.size());
+        buffer += ';';
+    }
+}
+
+bool MonsterTable::hasCreatureTrait(MonsterId monsterId, TraitId traitId) const
+{
+    if (traitId >= mTraitDictionary.size())
+    {
+        return false;
+    }
+
+    const auto word = mTraitMasks[static_cast<size_t>(getRecord(monsterId)) * mTraitMaskWords + traitId / BITS_PER_WORD];
+    return (word >> (traitId % BITS_PER_WORD) & 1) != 0;
+}
+
+const TraitDictionary& MonsterTable::getTraitDictionary() const
+{
+    return mTraitDictionary;
+}
+
+const Column<int32_t>& MonsterTable::getBaseLevels() const
+{
+    return mBaseLevels;
+}
+
+const Column<CreatureSize>& MonsterTable::getCreatureSizes() const
+{
+    return mCreatureSizes;
+}
+
+const Column<Rarity>& MonsterTable::getRarities() const
+{
+    return mRarities;
+}
+
+int MonsterTable::compareNames(MonsterId monsterId, const MonsterTable& other, MonsterId otherId) const
+{
+    const auto variant = getVariant(monsterId);
+    const auto otherVariant = other.getVariant(otherId);
+    const auto record = getRecord(monsterId);
+    const auto otherRecord = other.getRecord(otherId);
+
+    if (variant == otherVariant)
+    {
+        return mStrings.compare(mNames[record], other.mStrings, other.mNames[otherRecord]);
+    }
+
+    // Compare the names as if the variant prefixes were part of them, without building either name.
+    const auto* prefix = VARIANT_PREFIXES[static_cast<size_t>(variant)];
+    const auto* otherPrefix = VARIANT_PREFIXES[static_cast<size_t>(otherVariant)];
+    const auto prefixLength = std::strlen(prefix);
+    const auto otherPrefixLength = std::strlen(otherPrefix);
+    const auto length = prefixLength + mStrings.length(mNames[record]);
+    const auto otherLength = otherPrefixLength + other.mStrings.length(other.mNames[otherRecord]);
+    const auto* rest = mStrings.data(mNames[record]);
+    const auto* otherRest = other.mStrings.data(other.mNames[otherRecord]);
+
+    for (size_t index = 0; index < std::min(length, otherLength); ++index)
+    {
+        const auto character = joinedCharacter(prefix, prefixLength, rest, index);
+        const auto otherCharacter = joinedCharacter(otherPrefix, otherPrefixLength, otherRest, index);
+        if (character != otherCharacter)
+        {
+            return character < otherCharacter ? -1 : 1;
+        }
+    }
+
+    if (length == otherLength)
+    {
+        return 0;
+    }
+    return length < otherLength ? -1 : 1;
+}
+
+bool MonsterTable::isSameMonster(MonsterId monsterId, const MonsterTable& other, MonsterId otherId) const
+{
+    // Rarity is left out, the same as it always has been, since monsters made by hand are Common unless told otherwise.
+    if (getLevel(monsterId) != other.getLevel(otherId) ||
+        getCreatureSize(monsterId) != other.getCreatureSize(otherId))
+    {
+        return false;
+    }
+    if (compareNames(monsterId, other, otherId) != 0)
+    {
+        return false;
+    }
+    if (mStrings.compare(mLocations[getRecord(monsterId)], other.mStrings, other.mLocations[other.getRecord(otherId)]) != 0)
+    {
+        return false;
+    }
+
+    // Trait ids only mean the same thing inside one table, so across tables compare the traits themselves.
+    const auto traits = getCreatureTraits(monsterId);
+    const auto otherTraits = other.getCreatureTraits(otherId);
+    if (traits.size() != otherTraits.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < traits.size(); ++i)
+    {
+        if (this == &other ? traits[i] != otherTraits[i] : mTraitDictionary.getTrait(traits[i]) != other.mTraitDictionary.getTrait(otherTraits[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MonsterTable::writeCatalog(CatalogWriter& writer) const
+{
+    writer.writeValue(mNumMonsters);
+    writer.writeColumn(mBaseLevels);
+    writer.writeColumn(mCreatureSizes);
+    writer.writeColumn(mRarities);
+    writer.writeColumn(mVariants);
+    mStrings.writeCatalog(writer);
+    writer.writeColumn(mNames);
+    writer.writeColumn(mLocations);
+    mTraitDictionary.writeCatalog(writer);
+    writer.writeColumn(mTraitOffsets);
+    writer.writeColumn(mTraitIds);
+    writer.writeValue(mTraitMaskWords);
+    writer.writeColumn(mTraitMasks);
+}
+
+bool MonsterTable::readCatalog(CatalogReader& reader)
+{
+    // Read into a separate table so a bad catalog leaves this one alone.
+    MonsterTable table;
+    uint64_t numMonsters = 0;
+    uint64_t traitMaskWords = 0;
+    if (!reader.readValue(numMonsters) ||
+        !reader.readColumn(table.mBaseLevels) ||
+        !reader.readColumn(table.mCreatureSizes) ||
+        !reader.readColumn(table.mRarities) ||
+        !reader.readColumn(table.mVariants) ||
+        !table.mStrings.readCatalog(reader) ||
+        !reader.readColumn(table.mNames) ||
+        !reader.readColumn(table.mLocations) ||
+        !table.mTraitDictionary.readCatalog(reader) ||
+        !reader.readColumn(table.mTraitOffsets) ||
+        !reader.readColumn(table.mTraitIds) ||
+        !reader.readValue(traitMaskWords) ||
+        !reader.readColumn(table.mTraitMasks))
+    {
+        return false;
+    }
+
+    // Only the shape is checked. Looking at every value would touch every page of the catalog.
+    const auto numRecords = table.mBaseLevels.size();
+    if (numMonsters > numRecords * static_cast<size_t>(MonsterVariant::INVALID) ||
+        table.mCreatureSizes.size() != numRecords ||
+        table.mRarities.size() != numRecords ||
+        table.mVariants.size() != numRecords ||
+        table.mNames.size() != numRecords ||
+        table.mLocations.size() != numRecords ||
+        table.mTraitOffsets.size() != numRecords + 1 ||
+        table.mTraitOffsets[numRecords] != table.mTraitIds.size() ||
+        traitMaskWords * BITS_PER_WORD < table.mTraitDictionary.size() ||
+        table.mTraitMasks.size() != numRecords * traitMaskWords)
+    {
+        return false;
+    }
+
+    table.mNumMonsters = static_cast<uint32_t>(numMonsters);
+    table.mTraitMaskWords = static_cast<uint32_t>(traitMaskWords);
+    *this = table;
+    return true;
+}
+
+uint32_t MonsterTable::addRecord(const StringView& name, const int32_t& level, const CreatureSize& creatureSize, const Rarity& rarity,
+    const std::vector<StringView>& creatureTraits, const StringView& location)
+{
+    const auto record = getNumRecords();
+
+    mBaseLevels.getMutable().push_back(level);
+    mCreatureSizes.getMutable().push_back(creatureSize);
+    mRarities.getMutable().push_back(rarity);
+    mVariants.getMutable().push_back(0);
+    mNames.getMutable().push_back(mStrings.add(name));
+    mLocations.getMutable().push_back(mStrings.add(location));
+
+    // Intern first so the masks are already wide enough when this record gets its own.
+    auto& traitIds = mTraitIds.getMutable();
+    for (const auto& trait : creatureTraits)
+    {
+        traitIds.push_back(internTrait(trait));
+    }
+    mTraitOffsets.getMutable().push_back(static_cast<uint32_t>(traitIds.size()));
+
+    auto& traitMasks = mTraitMasks.getMutable();
+    traitMasks.resize(traitMasks.size() + mTraitMaskWords, 0);
+    for (auto traitIndex = mTraitOffsets[record]; traitIndex < mTraitOffsets[record + 1]; ++traitIndex)
+    {
+        const auto traitId = traitIds[traitIndex];
+        traitMasks[static_cast<size_t>(record) * mTraitMaskWords + traitId / BITS_PER_WORD] |= uint64_t{ 1 } << (traitId % BITS_PER_WORD);
+    }
+
+    return record;
+}
+
+TraitId MonsterTable::internTrait(const StringView& trait)
+{
+    const auto traitId = mTraitDictionary.intern(trait);
+    if (mTraitDictionary.size() <= mTraitMaskWords * BITS_PER_WORD)
+    {
+        return traitId;
+    }
+
+    // Out of bits, so lay every mask out again one word wider. Happens once per 64 distinct traits.
+    // A record that is still being added has no mask yet, so only count the ones with their traits in place.
+    const size_t numMasks = mTraitOffsets.size() - 1;
+    const auto newMaskWords = mTraitMaskWords + 1;
+    std::vector<uint64_t> newMasks(numMasks * newMaskWords, 0);
+    for (size_t record = 0; record < numMasks; ++record)
+    {
+        std::copy(mTraitMasks.begin() + record * mTraitMaskWords, mTraitMasks.begin() + (record + 1) * mTraitMaskWords, newMasks.begin() + record * newMaskWords);
+    }
+    mTraitMasks = Column<uint64_t>(std::move(newMasks));
+    mTraitMaskWords = newMaskWords;
+
+    return traitId;
+}
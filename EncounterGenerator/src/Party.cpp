@@ -76,7 +76,7 @@ uint32_t Party::getBattleXp(const Difficulty& difficulty) const
     auto desiredXp = 0;
 
     // Get their desired xp and multiply it by the number of adventurers. 
-    desiredXp += ADVENTURER_XP_BUDGET.at(difficulty) * mAdventurerCount;
+    desiredXp += GeneratorUtilities::getAdventurerXpBudget(difficulty) * mAdventurerCount;
 
     return desiredXp;
 }
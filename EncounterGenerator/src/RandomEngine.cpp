@@ -0,0 +1,178 @@
+#include "RandomEngine.h"
+
+#include <chrono>
+#include <random>
+
+namespace
+{
+    /**
+     * \brief Gets the next output of a splitmix64 generator, which spreads any seed out over the whole xoshiro state.
+     * \param state State of the splitmix64 generator, advanced by the call.
+     * \return Next output.
+     */
+    uint64_t splitMix64(uint64_t& state)
+    {
+        state += 0x9e3779b97f4a7c15ULL;
+        auto mixed = state;
+        mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebULL;
+        return mixed ^ (mixed >> 31);
+    }
+
+    /**
+     * \brief Rotates the bits of a word to the left.
+     * \param value Word to rotate.
+     * \param shift Number of bits to rotate by, between 1 and 63.
+     * \return Rotated word.
+     */
+    uint64_t rotateLeft(uint64_t value, int shift)
+    {
+        return (value << shift) | (value >> (64 - shift));
+    }
+
+    /**
+     * \brief Encrypts a 128 bit counter with Philox4x32-10, a counter based generator that turns any counter and key into well mixed bits.
+     * \param counter Counter to encrypt.
+     * \param key Key to encrypt with.
+     * \return Encrypted counter.
+     */
+    constexpr std::array<uint32_t, 4> philox4x32(const std::array<uint32_t, 4>& counter, const std::array<uint32_t, 2>& key)
+    {
+        const uint64_t MULTIPLIER_0 = 0xD2511F53;
+        const uint64_t MULTIPLIER_1 = 0xCD9E8D57;
+        const uint32_t KEY_STEP_0 = 0x9E3779B9;
+        const uint32_t KEY_STEP_1 = 0xBB67AE85;
+
+        // Kept in plain words, std::array can't be written to in a constexpr function before C++17.
+        uint32_t counter0 = counter[0];
+        uint32_t counter1 = counter[1];
+        uint32_t counter2 = counter[2];
+        uint32_t counter3 = counter[3];
+        uint32_t key0 = key[0];
+        uint32_t key1 = key[1];
+
+        for (int round = 0; round < 10; ++round)
+        {
+            if (round != 0)
+            {
+                key0 += KEY_STEP_0;
+                key1 += KEY_STEP_1;
+            }
+
+            const auto product0 = MULTIPLIER_0 * counter0;
+            const auto product1 = MULTIPLIER_1 * counter2;
+            counter0 = static_cast<uint32_t>(product1 >> 32) ^ counter1 ^ key0;
+            counter1 = static_cast<uint32_t>(product1);
+            counter2 = static_cast<uint32_t>(product0 >> 32) ^ counter3 ^ key1;
+            counter3 = static_cast<uint32_t>(product0);
+        }
+
+        return {{ counter0, counter1, counter2, counter3 }};
+    }
+
+    /**
+     * \brief Checks philox4x32 against an answer from the Random123 reference implementation.
+     * \param counter Counter to encrypt.
+     * \param key Key to encrypt with.
+     * \param expected What the reference implementation encrypts the counter to.
+     * \return If philox4x32 gives the same answer.
+     */
+    constexpr bool matchesKnownAnswer(const std::array<uint32_t, 4>& counter, const std::array<uint32_t, 2>& key, const std::array<uint32_t, 4>& expected)
+    {
+        const auto encrypted = philox4x32(counter, key);
+        return encrypted[0] == expected[0] && encrypted[1] == expected[1] && encrypted[2] == expected[2] && encrypted[3] == expected[3];
+    }
+
+    // Streams of a seed have to come out the same on every compiler, so the known answers are checked while compiling.
+    static_assert(matchesKnownAnswer({{ 0, 0, 0, 0 }}, {{ 0, 0 }},
+        {{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }}), "Philox4x32-10 of zeros is wrong.");
+    static_assert(matchesKnownAnswer({{ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }}, {{ 0xffffffff, 0xffffffff }},
+        {{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }}), "Philox4x32-10 of all ones is wrong.");
+    static_assert(matchesKnownAnswer({{ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }}, {{ 0xa4093822, 0x299f31d0 }},
+        {{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }}), "Philox4x32-10 of the digits of pi is wrong.");
+}
+
+RandomEngine::RandomEngine(uint64_t seed)
+{
+    this->seed(seed);
+}
+
+RandomEngine::RandomEngine(const std::array<uint64_t, 4>& state) :
+    mState(state)
+{
+}
+
+void RandomEngine::seed(uint64_t seed)
+{
+    // splitmix64 never gives four zeros in a row, which is the one state xoshiro can't leave.
+    for (auto& word : mState)
+    {
+        word = splitMix64(seed);
+    }
+}
+
+RandomEngine::result_type RandomEngine::operator()()
+{
+    const auto result = rotateLeft(mState[1] * 5, 7) * 9;
+    const auto shifted = mState[1] << 17;
+
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+
+    mState[2] ^= shifted;
+    mState[3] = rotateLeft(mState[3], 45);
+
+    return result;
+}
+
+uint64_t RandomEngine::nextBelow(uint64_t bound)
+{
+    // Numbers below the threshold would make the low results slightly more likely, so they get thrown away.
+    const auto threshold = (0 - bound) % bound;
+    for (;;)
+    {
+        const auto value = (*this)();
+        if (value >= threshold)
+        {
+            return value % bound;
+        }
+    }
+}
+
+RandomEngine RandomEngine::fromStream(uint64_t seed, uint64_t streamIndex)
+{
+    const std::array<uint32_t, 2> key = {{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) }};
+    const auto low = static_cast<uint32_t>(streamIndex);
+    const auto high = static_cast<uint32_t>(streamIndex >> 32);
+
+    // Two blocks fill the whole state. The third counter word tells them apart.
+    const auto first = philox4x32({{ low, high, 0, 0 }}, key);
+    const auto second = philox4x32({{ low, high, 1, 0 }}, key);
+
+    const std::array<uint64_t, 4> state = {{
+        static_cast<uint64_t>(first[1]) << 32 | first[0],
+        static_cast<uint64_t>(first[3]) << 32 | first[2],
+        static_cast<uint64_t>(second[1]) << 32 | second[0],
+        static_cast<uint64_t>(second[3]) << 32 | second[2]
+    }};
+
+    // xoshiro can't leave an all zero state. Philox won't realistically give one, but fall back to seeding just in case.
+    if ((state[0] | state[1] | state[2] | state[3]) == 0)
+    {
+        return RandomEngine(seed ^ streamIndex);
+    }
+    return RandomEngine(state);
+}
+
+RandomEngine& RandomEngine::getThreadEngine()
+{
+    thread_local RandomEngine engine([]
+    {
+        std::random_device device;
+        const auto time = static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+        return (static_cast<uint64_t>(device()) << 32 | device()) ^ time;
+    }());
+    return engine;
+}
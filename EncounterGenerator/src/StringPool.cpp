@@ -0,0 +1,87 @@
+#include "StringPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+StringPool::StringPool() :
+    mOffsets{ 0 }
+{
+}
+
+StringHandle StringPool::add(const StringView& string)
+{
+    auto& characters = mCharacters.getMutable();
+    characters.insert(characters.end(), string.begin(), string.end());
+
+    auto& offsets = mOffsets.getMutable();
+    offsets.push_back(static_cast<uint32_t>(characters.size()));
+    return static_cast<StringHandle>(offsets.size() - 2);
+}
+
+std::string StringPool::get(StringHandle handle) const
+{
+    return std::string(data(handle), length(handle));
+}
+
+const char* StringPool::data(StringHandle handle) const
+{
+    return mCharacters.data() + mOffsets[handle];
+}
+
+StringView StringPool::getView(StringHandle handle) const
+{
+    return StringView(data(handle), length(handle));
+}
+
+uint32_t StringPool::length(StringHandle handle) const
+{
+    return mOffsets[handle + 1] - mOffsets[handle];
+}
+
+int StringPool::compare(StringHandle handle, const StringPool& other, StringHandle otherHandle) const
+{
+    return compare(handle, other.data(otherHandle), other.length(otherHandle));
+}
+
+int StringPool::compare(StringHandle handle, const char* characters, size_t length) const
+{
+    const size_t ownLength = this->length(handle);
+    const auto commonLength = std::min(ownLength, length);
+    const auto result = commonLength == 0 ? 0 : std::memcmp(data(handle), characters, commonLength);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    if (ownLength == length)
+    {
+        return 0;
+    }
+    return ownLength < length ? -1 : 1;
+}
+
+uint32_t StringPool::size() const
+{
+    return static_cast<uint32_t>(mOffsets.size() - 1);
+}
+
+void StringPool::writeCatalog(CatalogWriter& writer) const
+{
+    writer.writeColumn(mCharacters);
+    writer.writeColumn(mOffsets);
+}
+
+bool StringPool::readCatalog(CatalogReader& reader)
+{
+    Column<char> characters;
+    Column<uint32_t> offsets;
+    if (!reader.readColumn(characters) || !reader.readColumn(offsets) ||
+        offsets.empty() || offsets[offsets.size() - 1] != characters.size())
+    {
+        return false;
+    }
+
+    mCharacters = characters;
+    mOffsets = offsets;
+    return true;
+}
@@ -0,0 +1,74 @@
+#include "TraitDictionary.h"
+
+#include <algorithm>
+
+const TraitId TraitDictionary::INVALID_TRAIT;
+
+TraitId TraitDictionary::intern(const StringView& trait)
+{
+    const auto position = lowerBound(trait);
+    if (position != mSortedTraitIds.size() && mTraits.compare(mSortedTraitIds[position], trait.data(), trait.size()) == 0)
+    {
+        return mSortedTraitIds[position];
+    }
+
+    // Only a few hundred distinct traits ever show up, so shifting the sorted ids over is cheap.
+    const auto traitId = mTraits.add(trait);
+    auto& sortedTraitIds = mSortedTraitIds.getMutable();
+    sortedTraitIds.insert(sortedTraitIds.begin() + position, traitId);
+    return traitId;
+}
+
+TraitId TraitDictionary::find(const StringView& trait) const
+{
+    const auto position = lowerBound(trait);
+    if (position == mSortedTraitIds.size() || mTraits.compare(mSortedTraitIds[position], trait.data(), trait.size()) != 0)
+    {
+        return INVALID_TRAIT;
+    }
+    return mSortedTraitIds[position];
+}
+
+std::string TraitDictionary::getTrait(TraitId traitId) const
+{
+    return mTraits.get(traitId);
+}
+
+StringView TraitDictionary::getTraitView(TraitId traitId) const
+{
+    return mTraits.getView(traitId);
+}
+
+uint32_t TraitDictionary::size() const
+{
+    return mTraits.size();
+}
+
+void TraitDictionary::writeCatalog(CatalogWriter& writer) const
+{
+    mTraits.writeCatalog(writer);
+    writer.writeColumn(mSortedTraitIds);
+}
+
+bool TraitDictionary::readCatalog(CatalogReader& reader)
+{
+    StringPool traits;
+    Column<TraitId> sortedTraitIds;
+    if (!traits.readCatalog(reader) || !reader.readColumn(sortedTraitIds) || sortedTraitIds.size() != traits.size())
+    {
+        return false;
+    }
+
+    mTraits = traits;
+    mSortedTraitIds = sortedTraitIds;
+    return true;
+}
+
+size_t TraitDictionary::lowerBound(const StringView& trait) const
+{
+    const auto found = std::lower_bound(mSortedTraitIds.begin(), mSortedTraitIds.end(), trait, [this](TraitId traitId, const StringView& wanted)
+    {
+        return mTraits.compare(traitId, wanted.data(), wanted.size()) < 0;
+    });
+    return static_cast<size_t>(found - mSortedTraitIds.begin());
+}
@@ -0,0 +1,214 @@
+#include "TraitSimilarityIndex.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+using namespace Pathfinder;
+
+namespace
+{
+    /**
+     * \brief Scrambles a value with the splitmix64 finalizer, so close values give unrelated hashes.
+     * \param value Value to scramble.
+     * \return Scrambled value.
+     */
+    uint64_t mixBits(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+}
+
+const uint32_t TraitSimilarityIndex::NUM_BANDS;
+const uint32_t TraitSimilarityIndex::ROWS_PER_BAND;
+const uint32_t TraitSimilarityIndex::SIGNATURE_SIZE;
+
+TraitSimilarityIndex::TraitSimilarityIndex(const MonsterTable& monsterTable, const MonsterIndex& monsterIndex, const std::vector<TraitId>& ignoredTraits) :
+    mIgnoredTraits(ignoredTraits)
+{
+    std::sort(mIgnoredTraits.begin(), mIgnoredTraits.end());
+
+    std::vector<Signature> signatures;
+    std::vector<TraitId> keptTraits;
+    std::vector<std::pair<std::vector<TraitId>, MonsterId>> levelMonsters;
+    mMinLevel = monsterIndex.getMinLevel();
+    mMaxLevel = monsterIndex.getMaxLevel();
+    mTraitOffsets.push_back(0);
+    mMonsterOffsets.push_back(0);
+    mLevelOffsets.push_back(0);
+    for (auto level = mMinLevel; level <= mMaxLevel; ++level)
+    {
+        levelMonsters.clear();
+        for (const auto& monsterId : monsterIndex.getMonstersOfLevel(level))
+        {
+            keepTraits(monsterTable.getCreatureTraits(monsterId), keptTraits);
+            if (!keptTraits.empty())
+            {
+                levelMonsters.emplace_back(keptTraits, monsterId);
+            }
+        }
+
+        // Lots of monsters share the exact same traits, like every human mercenary of a level, and they would all land in the same buckets.
+        // So each set of traits of a level is one entry holding all of its monsters, and a lookup only ever looks at each set once.
+        std::stable_sort(levelMonsters.begin(), levelMonsters.end(),
+            [](const std::pair<std::vector<TraitId>, MonsterId>& monster, const std::pair<std::vector<TraitId>, MonsterId>& other) { return monster.first < other.first; });
+        for (size_t monster = 0; monster < levelMonsters.size(); ++monster)
+        {
+            mEntryMonsters.push_back(levelMonsters[monster].second);
+            if (monster + 1 < levelMonsters.size() && levelMonsters[monster + 1].first == levelMonsters[monster].first)
+            {
+                continue;
+            }
+
+            const auto& entryTraits = levelMonsters[monster].first;
+            mEntryTraits.insert(mEntryTraits.end(), entryTraits.begin(), entryTraits.end());
+            mTraitOffsets.push_back(static_cast<uint32_t>(mEntryTraits.size()));
+            mMonsterOffsets.push_back(static_cast<uint32_t>(mEntryMonsters.size()));
+            signatures.push_back(getSignature(entryTraits));
+        }
+        mLevelOffsets.push_back(static_cast<uint32_t>(signatures.size()));
+    }
+
+    const auto numEntries = signatures.size();
+    mBucketKeys.resize(numEntries * NUM_BANDS);
+    mBucketEntries.resize(numEntries * NUM_BANDS);
+    std::vector<uint64_t> bandKeys(numEntries);
+    for (uint32_t band = 0; band < NUM_BANDS; ++band)
+    {
+        for (size_t entry = 0; entry < numEntries; ++entry)
+        {
+            bandKeys[entry] = getBucketKey(signatures[entry], band);
+        }
+
+        // Sort the entries of each level of the band by bucket so a bucket is one run found with a binary search over just that level.
+        auto* bandEntries = mBucketEntries.data() + band * numEntries;
+        std::iota(bandEntries, bandEntries + numEntries, 0);
+        for (size_t slot = 0; slot + 1 < mLevelOffsets.size(); ++slot)
+        {
+            std::stable_sort(bandEntries + mLevelOffsets[slot], bandEntries + mLevelOffsets[slot + 1],
+                [&bandKeys](uint32_t entry, uint32_t otherEntry) { return bandKeys[entry] < bandKeys[otherEntry]; });
+        }
+        for (size_t position = 0; position < numEntries; ++position)
+        {
+            mBucketKeys[band * numEntries + position] = bandKeys[bandEntries[position]];
+        }
+    }
+}
+
+bool TraitSimilarityIndex::findMostSimilar(const int32_t& level, const std::vector<TraitId>& traitIds, RandomEngine& engine, MonsterId& monsterId) const
+{
+    if (level < mMinLevel || level > mMaxLevel)
+    {
+        return false;
+    }
+
+    std::vector<TraitId> wantedTraits;
+    keepTraits(traitIds, wantedTraits);
+    if (wantedTraits.empty())
+    {
+        return false;
+    }
+
+    const auto signature = getSignature(wantedTraits);
+    const auto numEntries = mTraitOffsets.size() - 1;
+    const auto slot = static_cast<size_t>(level - mMinLevel);
+    std::vector<uint32_t> candidates;
+    for (uint32_t band = 0; band < NUM_BANDS; ++band)
+    {
+        const auto* bandKeys = mBucketKeys.data() + band * numEntries;
+        const auto bucket = std::equal_range(bandKeys + mLevelOffsets[slot], bandKeys + mLevelOffsets[slot + 1], getBucketKey(signature, band));
+        for (auto position = bucket.first; position != bucket.second; ++position)
+        {
+            candidates.push_back(mBucketEntries[band * numEntries + static_cast<size_t>(position - bandKeys)]);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Jaccard similarities are compared as fractions, shared over combined, so nothing is rounded.
+    uint32_t bestShared = 0;
+    uint32_t bestCombined = 1;
+    uint32_t numTied = 0;
+    for (const auto& entry : candidates)
+    {
+        const auto* firstTrait = mEntryTraits.data() + mTraitOffsets[entry];
+        const auto* lastTrait = mEntryTraits.data() + mTraitOffsets[entry + 1];
+        uint32_t shared = 0;
+        for (auto trait = firstTrait; trait != lastTrait; ++trait)
+        {
+            shared += std::binary_search(wantedTraits.begin(), wantedTraits.end(), *trait) ? 1 : 0;
+        }
+        const auto combined = static_cast<uint32_t>(wantedTraits.size() + (lastTrait - firstTrait)) - shared;
+
+        if (shared == 0)
+        {
+            continue;
+        }
+
+        // Every monster of an entry is a tie. Keeping the newest ties with a chance of their share of all the ties so far picks evenly among all of them.
+        const auto numEntryMonsters = mMonsterOffsets[entry + 1] - mMonsterOffsets[entry];
+        const auto comparison = static_cast<uint64_t>(shared) * bestCombined;
+        const auto bestComparison = static_cast<uint64_t>(bestShared) * combined;
+        if (comparison > bestComparison)
+        {
+            bestShared = shared;
+            bestCombined = combined;
+            numTied = numEntryMonsters;
+            monsterId = mEntryMonsters[mMonsterOffsets[entry] + (numEntryMonsters == 1 ? 0 : engine.nextBelow(numEntryMonsters))];
+        }
+        else if (comparison == bestComparison)
+        {
+            numTied += numEntryMonsters;
+            if (engine.nextBelow(numTied) < numEntryMonsters)
+            {
+                monsterId = mEntryMonsters[mMonsterOffsets[entry] + (numEntryMonsters == 1 ? 0 : engine.nextBelow(numEntryMonsters))];
+            }
+        }
+    }
+
+    return numTied != 0;
+}
+
+TraitSimilarityIndex::Signature TraitSimilarityIndex::getSignature(const std::vector<TraitId>& traitIds)
+{
+    Signature signature;
+    signature.fill(UINT32_MAX);
+    for (const auto& traitId : traitIds)
+    {
+        // Each row of the signature is its own hash function, told apart by mixing the row in with the trait.
+        for (uint32_t row = 0; row < SIGNATURE_SIZE; ++row)
+        {
+            const auto traitHash = static_cast<uint32_t>(mixBits((static_cast<uint64_t>(row) << 32) | traitId) >> 32);
+            signature[row] = std::min(signature[row], traitHash);
+        }
+    }
+    return signature;
+}
+
+uint64_t TraitSimilarityIndex::getBucketKey(const Signature& signature, uint32_t band)
+{
+    auto key = mixBits(band);
+    for (uint32_t row = 0; row < ROWS_PER_BAND; ++row)
+    {
+        key = mixBits(key ^ signature[band * ROWS_PER_BAND + row]);
+    }
+    return key;
+}
+
+template<typename TraitRange>
+void TraitSimilarityIndex::keepTraits(const TraitRange& traitIds, std::vector<TraitId>& keptTraits) const
+{
+    keptTraits.clear();
+    for (const auto& traitId : traitIds)
+    {
+        if (!std::binary_search(mIgnoredTraits.begin(), mIgnoredTraits.end(), traitId))
+        {
+            keptTraits.push_back(traitId);
+        }
+    }
+    std::sort(keptTraits.begin(), keptTraits.end());
+    keptTraits.erase(std::unique(keptTraits.begin(), keptTraits.end()), keptTraits.end());
+}
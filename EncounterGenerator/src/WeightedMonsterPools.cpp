@@ -0,0 +1,60 @@
+#include "WeightedMonsterPools.h"
+
+using namespace Pathfinder;
+
+WeightedMonsterPools::WeightedMonsterPools(const std::shared_ptr<const MonsterIndex>& monsterIndex, const MonsterTable& monsterTable,
+    const RarityWeights& rarityWeights) :
+    mMonsterIndex{ monsterIndex },
+    mRarityWeights{ rarityWeights },
+    mMinLevel{ monsterIndex->getMinLevel() },
+    mNumLevels{ monsterIndex->getMaxLevel() < monsterIndex->getMinLevel() ? 0 : static_cast<size_t>(monsterIndex->getMaxLevel() - monsterIndex->getMinLevel()) + 1 }
+{
+    const auto& rarities = monsterTable.getRarities();
+    mRecordWeights.reserve(rarities.size());
+    for (const auto& rarity : rarities)
+    {
+        mRecordWeights.push_back(mRarityWeights.getWeight(rarity));
+    }
+
+    mLevelTables.resize(mNumLevels);
+    mLevelTraitTables.resize(mNumLevels * monsterIndex->getNumTraits());
+}
+
+const RarityWeights& WeightedMonsterPools::getRarityWeights() const
+{
+    return mRarityWeights;
+}
+
+MonsterId WeightedMonsterPools::getRandomMonsterOfLevel(const int32_t& level, RandomEngine& engine) const
+{
+    const auto monsterIds = mMonsterIndex->getMonstersOfLevel(level);
+    const auto aliasTable = getAliasTable(mLevelTables[static_cast<size_t>(level - mMinLevel)], monsterIds);
+    return monsterIds[aliasTable->sample(engine)];
+}
+
+MonsterId WeightedMonsterPools::getRandomMonsterOfLevelWithTrait(const int32_t& level, TraitId traitId, RandomEngine& engine) const
+{
+    const auto monsterIds = mMonsterIndex->getMonstersOfLevelWithTrait(level, traitId);
+    const auto aliasTable = getAliasTable(mLevelTraitTables[static_cast<size_t>(traitId) * mNumLevels + static_cast<size_t>(level - mMinLevel)], monsterIds);
+    return monsterIds[aliasTable->sample(engine)];
+}
+
+std::shared_ptr<const AliasTable> WeightedMonsterPools::getAliasTable(std::shared_ptr<const AliasTable>& slot, const MonsterIdSpan& monsterIds) const
+{
+    // Two threads racing here both build the same table and one of them wins, which is harmless.
+    auto aliasTable = std::atomic_load(&slot);
+    if (!aliasTable)
+    {
+        std::vector<double> weights;
+        weights.reserve(monsterIds.size());
+        for (const auto& monsterId : monsterIds)
+        {
+            const auto record = MonsterTable::getRecord(monsterId);
+            weights.push_back(record < mRecordWeights.size() ? mRecordWeights[record] : mRarityWeights.common);
+        }
+
+        aliasTable = std::make_shared<const AliasTable>(weights);
+        std::atomic_store(&slot, aliasTable);
+    }
+    return aliasTable;
+}
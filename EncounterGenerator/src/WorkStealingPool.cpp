@@ -0,0 +1,150 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Lets a task find the queue of the thread it is running on.
+    thread_local const WorkStealingPool* tCurrentPool = nullptr;
+    thread_local size_t tCurrentQueue = 0;
+}
+
+WorkStealingPool::WorkStealingPool(const uint32_t& numThreads) :
+    mNumQueuedTasks{ 0 },
+    mNumUnfinishedTasks{ 0 },
+    mNextQueue{ 0 },
+    mStopping{ false }
+{
+    auto threadCount = numThreads != 0 ? numThreads : std::thread::hardware_concurrency();
+    threadCount = std::max(threadCount, 1u);
+
+    // Queue 0 belongs to whichever thread waits on the pool, the rest get a worker each.
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        mQueues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+        mThreads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mStopping = true;
+    }
+    mStateChanged.notify_all();
+
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    const auto queueIndex = tCurrentPool == this ? tCurrentQueue : mNextQueue++ % mQueues.size();
+
+    // Count the task before it can be taken, so the counts never drop below what is really there.
+    mNumUnfinishedTasks++;
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mNumQueuedTasks++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mQueues[queueIndex]->mutex);
+        mQueues[queueIndex]->tasks.push_back(std::move(task));
+    }
+    mStateChanged.notify_all();
+}
+
+void WorkStealingPool::wait()
+{
+    const auto previousPool = tCurrentPool;
+    const auto previousQueue = tCurrentQueue;
+    tCurrentPool = this;
+    tCurrentQueue = 0;
+
+    while (mNumUnfinishedTasks != 0)
+    {
+        if (!runTask(0))
+        {
+            std::unique_lock<std::mutex> lock(mStateMutex);
+            mStateChanged.wait(lock, [this] { return mNumUnfinishedTasks == 0 || mNumQueuedTasks != 0; });
+        }
+    }
+
+    tCurrentPool = previousPool;
+    tCurrentQueue = previousQueue;
+}
+
+uint32_t WorkStealingPool::getNumThreads() const
+{
+    return static_cast<uint32_t>(mQueues.size());
+}
+
+bool WorkStealingPool::runTask(const size_t& queueIndex)
+{
+    std::function<void()> task;
+
+    // Take the newest task from our own queue, it is the most likely to still be in cache.
+    {
+        auto& queue = *mQueues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+
+    // Otherwise steal the oldest task of another queue, which is the one furthest from what its owner is working on.
+    for (size_t i = 1; !task && i < mQueues.size(); ++i)
+    {
+        auto& queue = *mQueues[(queueIndex + i) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+
+    mNumQueuedTasks--;
+    task();
+
+    if (--mNumUnfinishedTasks == 0)
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mStateChanged.notify_all();
+    }
+    return true;
+}
+
+void WorkStealingPool::workerLoop(const size_t& queueIndex)
+{
+    tCurrentPool = this;
+    tCurrentQueue = queueIndex;
+
+    while (true)
+    {
+        if (runTask(queueIndex))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mStateMutex);
+        mStateChanged.wait(lock, [this] { return mStopping || mNumQueuedTasks != 0; });
+        if (mStopping)
+        {
+            return;
+        }
+    }
+}
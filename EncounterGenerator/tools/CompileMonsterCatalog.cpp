@@ -0,0 +1,49 @@
+#include "FileHelper.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace Pathfinder;
+
+/**
+ * \brief Compiles a json or csv monster list into a binary monster catalog that FileHelper::loadCatalog can map straight into memory.
+ *
+ * Usage: CompileMonsterCatalog <monster list path> <catalog path> [--unique]
+ * Lists ending in .csv are read as csv, anything else as json. Unique monsters are only put in the catalog when --unique is given.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 4 || (argc == 4 && std::string(argv[3]) != "--unique"))
+    {
+        std::cerr << "Usage: CompileMonsterCatalog <monster list path> <catalog path> [--unique]" << std::endl;
+        return 1;
+    }
+
+    const std::string monsterListPath = argv[1];
+    const std::string catalogPath = argv[2];
+    const auto parseUnique = argc == 4;
+
+    MonsterList monsterList;
+    try
+    {
+        const std::string csvExtension = ".csv";
+        const auto isCsv = monsterListPath.size() >= csvExtension.size() &&
+            monsterListPath.compare(monsterListPath.size() - csvExtension.size(), csvExtension.size(), csvExtension) == 0;
+        monsterList = isCsv ? FileHelper::parseCsv(monsterListPath, parseUnique) : FileHelper::parseJson(monsterListPath, parseUnique);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "Could not read " << monsterListPath << ": " << exception.what() << std::endl;
+        return 1;
+    }
+
+    if (!FileHelper::writeCatalog(monsterList, catalogPath))
+    {
+        std::cerr << "Could not write " << catalogPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Compiled " << monsterList.getMonsterTable()->size() << " monsters into " << catalogPath << std::endl;
+    return 0;
+}